@@ -1,5 +1,13 @@
-#include<iostream>
+﻿#include<iostream>
 #include<string>
+#include<cstring>
+#include<functional>
+#include<vector>
+#include<cstdlib>
+#ifdef _WIN32
+#include<io.h>      // _setmode：标准输入按二进制读取，偏移按原始字节计算
+#include<fcntl.h>
+#endif
 using std::cin;
 using std::cout;
 using std::string;
@@ -12,20 +20,83 @@ enum DFAState {
 	AfterDotDigit,
 	ESign,
 	AfterEDigit,
+	Dead,       // 出错后停留的状态
 	STATECOUNT,
 };
 
+// 各部分在输入中的区间 [begin, end)，不存在的部分为 (-1, -1)
+struct Span {
+	int begin = -1;
+	int end = -1;
+};
+
+struct PascalNumberParts {
+	Span integer;   // 整数部分
+	Span fraction;  // 小数点后的部分
+	Span exponent;  // E 之后的部分（含符号）
+};
+
+// 流式识别中的一条记录（以空白分隔的一个单词），偏移均为从流开头算起的绝对位置
+struct StreamMatch {
+	size_t begin;      // 记录起点
+	size_t end;        // 记录终点（不含）
+	bool matched;      // 整条记录是否为合法的无符号数
+	size_t prefixEnd;  // 最长合法前缀的终点，没有合法前缀时为 string::npos
+};
+
+// 可恢复的识别器：只保存当前状态和上一个接受位置，输入可以任意切块，
+// 跨块的单词不需要缓存之前的块，内存占用与流的长度无关
+class PascalNumberStream {
+public:
+	using Callback = std::function<void(const StreamMatch&)>;
+
+	explicit PascalNumberStream(Callback onRecord) : onRecord(onRecord) {}
+
+	void feed(const char* data, size_t size);
+	void finish();
+
+private:
+	Callback onRecord;
+	DFAState state = Start;
+	size_t offset = 0;
+	size_t recordBegin = 0;
+	size_t lastAccept = string::npos;
+	bool inRecord = false;
+
+	void endRecord();
+};
+
+DFAState nextState(DFAState state, char c);
+bool isAcceptState(DFAState state);
 bool isValidPascalNumber(const string& pascalNumber);
+bool parsePascalNumber(const string& pascalNumber, PascalNumberParts& parts);
+void printSpan(const char* name, const Span& span, const string& pascalNumber);
+int runStream(size_t chunkSize);
+
+int main(int argc, char* argv[]) {
+	// --stream [块大小]：从标准输入分块读取（默认每块 4096 字节），逐个单词输出识别结果
+	if (argc > 1 && std::strcmp(argv[1], "--stream") == 0) {
+		int chunkSize = argc > 2 ? std::atoi(argv[2]) : 4096;
+		if (chunkSize <= 0) {
+			std::cerr << "Error: chunk size must be a positive number.\n";
+			return 1;
+		}
+		return runStream((size_t)chunkSize);
+	}
 
-int main() {
 	string pascalNumber;
 	while (true) {
 		cout << "Enter a Pascal unsigned number: ";
 		if (!(cin >> pascalNumber)) {
 			break;
 		}
-		if (isValidPascalNumber(pascalNumber)) {
-			cout << "YES\n";
+		PascalNumberParts parts;
+		if (parsePascalNumber(pascalNumber, parts)) {
+			cout << "YES";
+			printSpan("integer", parts.integer, pascalNumber);
+			printSpan("fraction", parts.fraction, pascalNumber);
+			printSpan("exponent", parts.exponent, pascalNumber);
+			cout << "\n";
 		}
 		else {
 			cout << "NO\n";
@@ -33,68 +104,163 @@ int main() {
 	}
 }
 
+int runStream(size_t chunkSize)
+{
+#ifdef _WIN32
+	_setmode(_fileno(stdin), _O_BINARY);
+#endif
+	PascalNumberStream stream([](const StreamMatch& m) {
+		cout << m.begin << "-" << m.end << ": " << (m.matched ? "YES" : "NO");
+		if(!m.matched && m.prefixEnd != string::npos)
+			cout << " (longest number prefix ends at " << m.prefixEnd << ")";
+		cout << "\n";
+	});
+
+	std::vector<char> chunk(chunkSize);
+	while(cin.read(chunk.data(), chunk.size()) || cin.gcount() > 0)
+	{
+		stream.feed(chunk.data(), (size_t)cin.gcount());
+	}
+	stream.finish();
+	return 0;
+}
+
 bool isValidPascalNumber(const string& pascalNumber)
 {
+	PascalNumberParts parts;
+	return parsePascalNumber(pascalNumber, parts);
+}
+
+void printSpan(const char* name, const Span& span, const string& pascalNumber)
+{
+	if(span.begin < 0)
+		return;
+	cout << " " << name << "=[" << span.begin << "," << span.end << ")"
+		<< pascalNumber.substr(span.begin, span.end - span.begin);
+}
+
+DFAState nextState(DFAState state, char c)
+{
+	switch(state)
+	{
+		case Start:
+			if(c>='0' && c<='9')
+				return DigitBeforeDotAndE;
+			return Dead;
+		case DigitBeforeDotAndE:
+			if(c>='0' && c<='9')
+				return DigitBeforeDotAndE;
+			else if(c=='.')
+				return DOT;
+			else if(c=='E' || c=='e')
+				return E;
+			return Dead;
+		case DOT:
+			if(c>='0' && c<='9')
+				return AfterDotDigit;
+			return Dead;
+		case AfterDotDigit:
+			if(c>='0' && c<='9')
+				return AfterDotDigit;
+			else if(c=='E' || c=='e')
+				return E;
+			return Dead;
+		case E:
+			if(c=='+' || c=='-')
+				return ESign;
+			else if(c>='0' && c<='9')
+				return AfterEDigit;
+			return Dead;
+		case ESign:
+			if(c>='0' && c<='9')
+				return AfterEDigit;
+			return Dead;
+		case AfterEDigit:
+			if(c>='0' && c<='9')
+				return AfterEDigit;
+			return Dead;
+		default:
+			return Dead;
+	}
+}
+
+// 只有停在数字之后才是完整的无符号数，"12."、"1E"、"1E+" 都不是
+bool isAcceptState(DFAState state)
+{
+	return state == DigitBeforeDotAndE || state == AfterDotDigit || state == AfterEDigit;
+}
+
+// 在识别的同一遍扫描中记录各部分的位置：进入 / 离开某一部分的转移上记下当前位置
+bool parsePascalNumber(const string& pascalNumber, PascalNumberParts& parts)
+{
+	parts = PascalNumberParts();
 	DFAState currentState = Start;
+	int pos = 0;
 	for(char c:pascalNumber)
 	{
-		switch(currentState)
+		DFAState next = nextState(currentState, c);
+		if(next == Dead)
+			return false;
+		if(currentState == Start)
+			parts.integer.begin = pos;
+		else if(currentState == DigitBeforeDotAndE && next != DigitBeforeDotAndE)
+			parts.integer.end = pos;
+		else if(currentState == DOT)
+			parts.fraction.begin = pos;
+		else if(currentState == AfterDotDigit && next != AfterDotDigit)
+			parts.fraction.end = pos;
+		else if(currentState == E)
+			parts.exponent.begin = pos;
+		currentState = next;
+		++pos;
+	}
+
+	if(!isAcceptState(currentState))
+		return false;
+	if(currentState == DigitBeforeDotAndE)
+		parts.integer.end = pos;
+	else if(currentState == AfterDotDigit)
+		parts.fraction.end = pos;
+	else
+		parts.exponent.end = pos;
+	return true;
+}
+
+void PascalNumberStream::feed(const char* data, size_t size)
+{
+	for(size_t i = 0; i < size; ++i, ++offset)
+	{
+		char c = data[i];
+		if(c==' ' || c=='\t' || c=='\n' || c=='\r' || c=='\f' || c=='\v')
+		{
+			endRecord();
+			continue;
+		}
+		if(!inRecord)
+		{
+			inRecord = true;
+			recordBegin = offset;
+		}
+		if(state != Dead)
 		{
-			case Start:
-				if(c>='0' && c<='9')
-					currentState = DigitBeforeDotAndE;
-				else
-					return false;
-				break;
-			case DigitBeforeDotAndE:
-				if(c>='0' && c<='9')
-					currentState = DigitBeforeDotAndE;
-				else if(c=='.')
-					currentState = DOT;
-				else if(c=='E' || c=='e')
-					currentState = E;
-				else
-					return false;
-				break;
-			case DOT:
-				if(c>='0' && c<='9')
-					currentState = AfterDotDigit;
-				else
-					return false;
-				break;
-			case AfterDotDigit:
-				if(c>='0' && c<='9')
-					currentState = AfterDotDigit;
-				else if(c=='E' || c=='e')
-					currentState = E;
-				else
-					return false;
-				break;
-			case E:
-				if(c=='+' || c=='-')
-					currentState = ESign;
-				else if(c>='0' && c<='9')
-					currentState = AfterEDigit;
-				else
-					return false;
-				break;
-			case ESign:
-				if(c>='0' && c<='9')
-					currentState = AfterEDigit;
-				else
-					return false;
-				break;
-			case AfterEDigit:
-				if(c>='0' && c<='9')
-					currentState = AfterEDigit;
-				else
-					return false;
-				break;
-			default:
-				return false;
+			state = nextState(state, c);
+			if(isAcceptState(state))
+				lastAccept = offset + 1;
 		}
 	}
-	return true;
 }
 
+void PascalNumberStream::finish()
+{
+	endRecord();
+}
 
+void PascalNumberStream::endRecord()
+{
+	if(!inRecord)
+		return;
+	onRecord({ recordBegin, offset, isAcceptState(state), lastAccept });
+	state = Start;
+	lastAccept = string::npos;
+	inRecord = false;
+}
@@ -20,6 +20,35 @@
 #include <map>
 #include <queue>
 #include <cctype>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <algorithm>
+#include <iterator>
+#include <functional>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define DFA_JIT_X64 1
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+#endif
+
+#ifdef _WIN32
+#include <io.h>     // _setmode：标准输入按二进制读取，--stream 的偏移按原始字节计算
+#include <fcntl.h>
+#endif
 
 struct NFANode;
 
@@ -28,6 +57,7 @@ struct NFANode;
 struct NFAEdge {
     char symbol;     // '\0' 表示 epsilon
     NFANode* to;
+    int tag = -1;    // 仅 epsilon 边使用：经过时记录当前位置的标签号，-1 表示无标签
 };
 
 struct NFANode {
@@ -43,6 +73,7 @@ struct NFA {
     std::vector<NFANode*> states;
     std::set<char> alphabet;   // 不包含 epsilon
 	std::string regex;        // 原始正则表达式
+    int groupCount = 0;       // 捕获组个数，第 g 组对应标签 2(g-1)（开始）和 2(g-1)+1（结束）
 };
 
 // Thompson 构造中的碎片
@@ -62,6 +93,81 @@ bool isLiteral(char c) {
     return !isOperator(c) && !isspace(static_cast<unsigned char>(c));
 }
 
+// -------------------- 工具函数：UTF-8 --------------------
+// 正规式按 UTF-8 书写，多字节字符是一个整体；编译出的 DFA 直接在原始字节上运行。
+
+const int MAX_CODE_POINT = 0x10FFFF;
+
+bool isContinuationByte(char c) {
+    return (static_cast<unsigned char>(c) & 0xC0) == 0x80;
+}
+
+/// @brief 解码 s[i] 开始的一个 UTF-8 字符
+/// @param i 成功时移动到下一个字符，失败时只前进一个字节
+/// @return 码点；非法序列返回 -1
+int decodeUTF8(const std::string& s, size_t& i) {
+    unsigned char b = static_cast<unsigned char>(s[i]);
+    int len = b < 0x80 ? 1 : (b >> 5) == 0x6 ? 2 : (b >> 4) == 0xE ? 3 : (b >> 3) == 0x1E ? 4 : 0;
+    if (len == 0 || i + len > s.size()) {
+        ++i;
+        return -1;
+    }
+    int cp = len == 1 ? b : (b & (0xFF >> (len + 1)));
+    for (int k = 1; k < len; ++k) {
+        if (!isContinuationByte(s[i + k])) {
+            ++i;
+            return -1;
+        }
+        cp = (cp << 6) | (static_cast<unsigned char>(s[i + k]) & 0x3F);
+    }
+    static const int minForLen[] = { 0, 0, 0x80, 0x800, 0x10000 };
+    if (cp < minForLen[len] || cp > MAX_CODE_POINT || (cp >= 0xD800 && cp <= 0xDFFF)) {
+        ++i;
+        return -1; // 过长编码、超范围或代理区
+    }
+    i += len;
+    return cp;
+}
+
+std::string encodeUTF8(int cp) {
+    std::string out;
+    if (cp < 0x80) {
+        out.push_back((char)cp);
+    }
+    else if (cp < 0x800) {
+        out.push_back((char)(0xC0 | (cp >> 6)));
+        out.push_back((char)(0x80 | (cp & 0x3F)));
+    }
+    else if (cp < 0x10000) {
+        out.push_back((char)(0xE0 | (cp >> 12)));
+        out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (cp & 0x3F)));
+    }
+    else {
+        out.push_back((char)(0xF0 | (cp >> 18)));
+        out.push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back((char)(0x80 | (cp & 0x3F)));
+    }
+    return out;
+}
+
+// 输出转移符号：可打印 ASCII 原样输出，其余字节输出为 \xHH
+std::string symbolToString(char c) {
+    unsigned char b = static_cast<unsigned char>(c);
+    if (b >= 0x20 && b < 0x7F) {
+        return std::string(1, c);
+    }
+    const char* hex = "0123456789ABCDEF";
+    return std::string("\\x") + hex[b >> 4] + hex[b & 0xF];
+}
+
+// 字符类 [...] 的长度（含两端方括号），没有右括号时返回 npos
+size_t bracketLength(const std::string& regex, size_t i) {
+    size_t close = regex.find(']', i + 1);
+    return close == std::string::npos ? close : close - i + 1;
+}
+
 // -------------------- 第一步：在正则式中显式插入连接符 '.' --------------------
 // 例如： (a|b)*b  ->  (a|b)*.b
 std::string insertConcatOperators(const std::string& regex) {
@@ -74,7 +180,10 @@ std::string insertConcatOperators(const std::string& regex) {
             continue; // 忽略空白
         }
 
-        if (!result.empty()) {
+        // 多字节 UTF-8 字符的后续字节与前面的字节是一个整体，不插入连接符
+        bool insideCodePoint = isContinuationByte(c) && static_cast<unsigned char>(prev) >= 0x80;
+
+        if (!result.empty() && !insideCodePoint) {
             bool prevIsLiteralOrRightOrStar =
                 isLiteral(prev) || prev == ')' || prev == '*';
             bool currIsLiteralOrLeft =
@@ -85,8 +194,15 @@ std::string insertConcatOperators(const std::string& regex) {
             }
         }
 
-        result.push_back(c);
-        prev = c;
+        // 字符类 [...] 整体照抄，内部不插入连接符
+        size_t len = (c == '[') ? bracketLength(regex, i) : 1;
+        if (len == std::string::npos) {
+            std::cerr << "Error: unterminated character class in regex.\n";
+            len = 1;
+        }
+        result.append(regex, i, len);
+        i += len - 1;
+        prev = regex[i];
     }
 
     return result;
@@ -107,8 +223,15 @@ std::string toPostfix(const std::string& regexWithConcat) {
     std::string output;
     std::stack<char> opStack; // 运算符栈
 
-    for (char c : regexWithConcat) {
-        if (isLiteral(c)) {
+    for (size_t i = 0; i < regexWithConcat.size(); ++i) {
+        char c = regexWithConcat[i];
+        size_t len = (c == '[') ? bracketLength(regexWithConcat, i) : std::string::npos;
+        if (len != std::string::npos) {
+            // 字符类作为一个操作数照抄
+            output.append(regexWithConcat, i, len);
+            i += len - 1;
+        }
+        else if (isLiteral(c)) {
             output.push_back(c);
         }
         else if (c == '(') {
@@ -121,6 +244,8 @@ std::string toPostfix(const std::string& regexWithConcat) {
             }
             if (!opStack.empty() && opStack.top() == '(') {
                 opStack.pop();
+                // ')' 作为后缀一元运算输出，标记一个捕获组
+                output.push_back(')');
             }
             else {
                 std::cerr << "Error: mismatched parentheses in regex.\n";
@@ -154,72 +279,394 @@ std::string toPostfix(const std::string& regexWithConcat) {
     return output;
 }
 
-// -------------------- 第三步：Thompson 构造 NFA --------------------
+// -------------------- 第三步：后缀表达式 -> 语法树，并做代数化简 --------------------
+// 直接从后缀式构造 Thompson 碎片时，(a*)*、a*a*、(a|a) 这类冗余结构会原样变成多余的 NFA 状态，
+// 进而增加子集构造的工作量。这里先建立显式的语法树，化简之后再构造 NFA。
+
+enum class RegexKind {
+    Literal,  // 单个字节（ASCII 字符，或非法 UTF-8 序列中的原始字节）
+    Class,    // 码点区间集合：[a-z]、多字节字符，以及单字符并集 a|b|c 合并成的 [abc]
+    Concat,   // n 元连接
+    Union,    // n 元选择
+    Star,     // 闭包，只有一个孩子
+    Group     // 捕获组（括号），只有一个孩子；化简时去掉
+};
 
-class NFAFactory {
-public:
-    NFAFactory() : nextId(1) {}
+struct RegexAST;
+using RegexPtr = std::shared_ptr<RegexAST>;
+using CodePointRange = std::pair<int, int>; // 闭区间 [first, second]
+
+struct RegexAST {
+    RegexKind kind = RegexKind::Literal;
+    char symbol = '\0';                  // Literal 使用
+    std::vector<CodePointRange> ranges;  // Class 使用，有序且互不相邻
+    int group = 0;                       // Group 使用，按左括号出现顺序从 1 编号
+    std::vector<RegexPtr> children; // Concat / Union / Star 使用
+    std::string key;                // regexKey 的缓存，解析完成后结点不再修改
+};
 
-    NFA buildFromRegex(const std::string& regex) {
-        std::string withConcat = insertConcatOperators(regex);
-        std::string postfix = toPostfix(withConcat);
-        // std::cerr << "postfix: " << postfix << "\n";
+RegexPtr makeLiteral(char c) {
+    RegexPtr node = std::make_shared<RegexAST>();
+    node->kind = RegexKind::Literal;
+    node->symbol = c;
+    return node;
+}
+
+RegexPtr makeNode(RegexKind kind, std::vector<RegexPtr> children) {
+    RegexPtr node = std::make_shared<RegexAST>();
+    node->kind = kind;
+    node->children = std::move(children);
+    return node;
+}
 
-        std::stack<NFAFragment> st;
+// 区间排序并合并重叠 / 相邻的区间；只含一个 ASCII 字符时退化为 Literal
+RegexPtr makeClass(std::vector<CodePointRange> ranges) {
+    std::sort(ranges.begin(), ranges.end());
+    std::vector<CodePointRange> merged;
+    for (const auto& r : ranges) {
+        if (!merged.empty() && r.first <= merged.back().second + 1) {
+            merged.back().second = std::max(merged.back().second, r.second);
+        }
+        else {
+            merged.push_back(r);
+        }
+    }
+    if (merged.size() == 1 && merged[0].first == merged[0].second && merged[0].first < 0x80) {
+        return makeLiteral((char)merged[0].first);
+    }
+    RegexPtr node = std::make_shared<RegexAST>();
+    node->kind = RegexKind::Class;
+    node->ranges = merged;
+    return node;
+}
+
+/// @brief 解析字符类 [...] 的内容，支持单个字符与 x-y 区间
+RegexPtr parseBracket(const std::string& body) {
+    std::vector<CodePointRange> ranges;
+    size_t i = 0;
+    while (i < body.size()) {
+        int lo = decodeUTF8(body, i);
+        int hi = lo;
+        if (i + 1 < body.size() && body[i] == '-') {
+            ++i;
+            hi = decodeUTF8(body, i);
+        }
+        if (lo < 0 || hi < 0) {
+            std::cerr << "Warning: invalid UTF-8 in character class, ignored.\n";
+            continue;
+        }
+        if (lo > hi) {
+            std::cerr << "Warning: empty range in character class, ignored.\n";
+            continue;
+        }
+        ranges.push_back({ lo, hi });
+    }
+    if (ranges.empty()) {
+        std::cerr << "Error: empty character class in regex.\n";
+        return nullptr;
+    }
+    return makeClass(ranges);
+}
 
-        for (char c : postfix) {
-            if (isLiteral(c)) {
-                st.push(buildLiteral(c));
+/// @brief 由后缀表达式构造语法树
+/// @param postfix toPostfix 的输出
+/// @return 语法树根结点，正则式非法时返回 nullptr
+RegexPtr parsePostfix(const std::string& postfix) {
+    std::stack<RegexPtr> st;
+
+    for (size_t i = 0; i < postfix.size(); ++i) {
+        char c = postfix[i];
+        if (c == '[' && bracketLength(postfix, i) != std::string::npos) {
+            size_t len = bracketLength(postfix, i);
+            RegexPtr cls = parseBracket(postfix.substr(i + 1, len - 2));
+            if (!cls) return nullptr;
+            st.push(cls);
+            i += len - 1;
+        }
+        else if (static_cast<unsigned char>(c) >= 0x80) {
+            // 多字节字符作为一个码点；非法序列按原始字节处理
+            size_t next = i;
+            int cp = decodeUTF8(postfix, next);
+            if (cp < 0) {
+                st.push(makeLiteral(c));
             }
-            else if (c == '.') {
-                if (st.size() < 2) {
-                    std::cerr << "Error: invalid regex (concat stack underflow).\n";
-                    break;
-                }
-                NFAFragment right = st.top(); st.pop();
-                NFAFragment left = st.top(); st.pop();
-                st.push(buildConcat(left, right));
-            }
-            else if (c == '|') {
-                if (st.size() < 2) {
-                    std::cerr << "Error: invalid regex (union stack underflow).\n";
-                    break;
-                }
-                NFAFragment right = st.top(); st.pop();
-                NFAFragment left = st.top(); st.pop();
-                st.push(buildUnion(left, right));
-            }
-            else if (c == '*') {
-                if (st.empty()) {
-                    std::cerr << "Error: invalid regex (star stack underflow).\n";
-                    break;
-                }
-                NFAFragment frag = st.top(); st.pop();
-                st.push(buildStar(frag));
+            else {
+                st.push(makeClass({ { cp, cp } }));
+                i = next - 1;
+            }
+        }
+        else if (isLiteral(c)) {
+            st.push(makeLiteral(c));
+        }
+        else if (c == '.' || c == '|') {
+            if (st.size() < 2) {
+                std::cerr << "Error: invalid regex (" << (c == '.' ? "concat" : "union")
+                    << " stack underflow).\n";
+                return nullptr;
+            }
+            // 同类运算直接并入 n 元结点，a|b|c|... 不会变成一条每个 | 一层的左深链，
+            // 树的深度只随括号嵌套增长，后续的递归化简与构造不会因分支多而爆栈
+            RegexKind kind = c == '.' ? RegexKind::Concat : RegexKind::Union;
+            RegexPtr right = st.top(); st.pop();
+            RegexPtr left = st.top(); st.pop();
+            if (left->kind != kind) left = makeNode(kind, { left });
+            if (right->kind == kind) {
+                left->children.insert(left->children.end(), right->children.begin(), right->children.end());
             }
             else {
-				std::cerr << "Warning: unknown character in postfix regex: " << c << "\n";
+                left->children.push_back(right);
+            }
+            st.push(left);
+        }
+        else if (c == '*' || c == ')') {
+            if (st.empty()) {
+                std::cerr << "Error: invalid regex (" << (c == '*' ? "star" : "group")
+                    << " stack underflow).\n";
+                return nullptr;
+            }
+            RegexPtr child = st.top(); st.pop();
+            st.push(makeNode(c == '*' ? RegexKind::Star : RegexKind::Group, { child }));
+        }
+        else {
+            std::cerr << "Warning: unknown character in postfix regex: " << c << "\n";
+        }
+    }
+
+    if (st.size() != 1) {
+        std::cerr << "Error: invalid regex, stack size: " << st.size() << "\n";
+        return nullptr;
+    }
+    return st.top();
+}
+
+/// @brief 语法树的规范串，结构相同的子树得到相同的串，用于判重
+/// 采用带长度的前缀编码，避免字面字符与结构符号混淆。
+/// 每个结点只计算一次，结果缓存在结点上；化简只会新建结点，不修改已有结点
+const std::string& regexKey(const RegexPtr& node) {
+    if (!node->key.empty()) return node->key;
+    std::string key;
+    switch (node->kind) {
+    case RegexKind::Literal:
+        key = std::string("L") + node->symbol;
+        break;
+    case RegexKind::Class:
+        key = "C" + std::to_string(node->ranges.size()) + ":";
+        for (const auto& r : node->ranges) {
+            key += std::to_string(r.first) + "-" + std::to_string(r.second) + ",";
+        }
+        break;
+    case RegexKind::Star:
+        key = "*" + regexKey(node->children[0]);
+        break;
+    case RegexKind::Group:
+        key = "(" + std::to_string(node->group) + regexKey(node->children[0]);
+        break;
+    default:
+        key = (node->kind == RegexKind::Concat) ? "." : "|";
+        key += std::to_string(node->children.size()) + ":";
+        for (const auto& child : node->children) key += regexKey(child);
+        break;
+    }
+    node->key = std::move(key);
+    return node->key;
+}
+
+RegexPtr simplifyRegex(const RegexPtr& node);
+
+// 连接：展平嵌套连接，合并相邻的相同闭包 r*r* -> r*
+RegexPtr simplifyConcat(const std::vector<RegexPtr>& parts) {
+    std::vector<RegexPtr> flat;
+    auto append = [&](const RegexPtr& piece) {
+        if (piece->kind == RegexKind::Star && !flat.empty() && regexKey(flat.back()) == regexKey(piece)) {
+            return; // r*r* 与 r* 等价
+        }
+        flat.push_back(piece);
+    };
+    for (const auto& part : parts) {
+        if (part->kind == RegexKind::Concat) {
+            for (const auto& piece : part->children) append(piece);
+        }
+        else {
+            append(part);
+        }
+    }
+    if (flat.size() == 1) return flat[0];
+    return makeNode(RegexKind::Concat, flat);
+}
+
+// 取一个分支的首项及剩余部分（剩余部分为空时返回 nullptr）
+RegexPtr headOf(const RegexPtr& branch) {
+    return branch->kind == RegexKind::Concat ? branch->children[0] : branch;
+}
+
+RegexPtr tailOf(const RegexPtr& branch) {
+    if (branch->kind != RegexKind::Concat) return nullptr;
+    std::vector<RegexPtr> rest(branch->children.begin() + 1, branch->children.end());
+    return rest.size() == 1 ? rest[0] : makeNode(RegexKind::Concat, rest);
+}
+
+// 选择：展平嵌套选择、去除重复分支、提取公共前缀、把单字符分支合并为字符类
+RegexPtr simplifyUnion(const std::vector<RegexPtr>& parts) {
+    // 1. 展平并去重（保留首次出现的顺序）
+    std::vector<RegexPtr> branches;
+    std::set<std::string> seen;
+    auto append = [&](const RegexPtr& piece) {
+        if (seen.insert(regexKey(piece)).second) branches.push_back(piece);
+    };
+    for (const auto& part : parts) {
+        if (part->kind == RegexKind::Union) {
+            for (const auto& piece : part->children) append(piece);
+        }
+        else {
+            append(part);
+        }
+    }
+
+    // 2. 提取公共前缀：ab|ac -> a(b|c)
+    // 没有空串结点，因此某个分支恰好等于前缀（如 a|ab）时不做提取
+    std::vector<std::vector<RegexPtr>> groups;
+    std::map<std::string, int> headToGroup;
+    for (const auto& branch : branches) {
+        const std::string& key = regexKey(headOf(branch));
+        auto it = headToGroup.find(key);
+        if (it == headToGroup.end()) {
+            headToGroup[key] = (int)groups.size();
+            groups.push_back({ branch });
+        }
+        else {
+            groups[it->second].push_back(branch);
+        }
+    }
+
+    std::vector<RegexPtr> factored;
+    for (const auto& group : groups) {
+        bool canFactor = group.size() > 1;
+        std::vector<RegexPtr> tails;
+        for (const auto& branch : group) {
+            RegexPtr tail = tailOf(branch);
+            if (!tail) {
+                canFactor = false;
+                break;
+            }
+            tails.push_back(tail);
+        }
+        if (!canFactor) {
+            factored.insert(factored.end(), group.begin(), group.end());
+            continue;
+        }
+        RegexPtr rest = simplifyUnion(tails);
+        factored.push_back(simplifyConcat({ headOf(group[0]), rest }));
+    }
+
+    // 3. 单字符分支合并为字符类，放在第一个单字符分支的位置
+    // 原始字节（非法 UTF-8）不是码点，不参与合并
+    std::vector<RegexPtr> result;
+    std::vector<CodePointRange> ranges;
+    int classPos = -1;
+    for (const auto& branch : factored) {
+        bool isAsciiLiteral = branch->kind == RegexKind::Literal &&
+            static_cast<unsigned char>(branch->symbol) < 0x80;
+        if (isAsciiLiteral || branch->kind == RegexKind::Class) {
+            if (classPos < 0) {
+                classPos = (int)result.size();
+                result.push_back(nullptr); // 占位
             }
+            if (isAsciiLiteral) ranges.push_back({ branch->symbol, branch->symbol });
+            else ranges.insert(ranges.end(), branch->ranges.begin(), branch->ranges.end());
+        }
+        else {
+            result.push_back(branch);
         }
+    }
+    if (classPos >= 0) {
+        result[classPos] = makeClass(ranges);
+    }
+
+    if (result.size() == 1) return result[0];
+    return makeNode(RegexKind::Union, result);
+}
+
+/// @brief 自底向上化简语法树
+/// (r*)* -> r*，r*r* -> r*，(r|r) -> r，ab|ac -> a(b|c)，a|b|c -> [abc]
+RegexPtr simplifyRegex(const RegexPtr& node) {
+    if (!node) return node;
 
-        if (st.size() != 1) {
-            std::cerr << "Error: invalid regex, stack size: " << st.size() << "\n";
+    std::vector<RegexPtr> children;
+    for (const auto& child : node->children) {
+        children.push_back(simplifyRegex(child));
+    }
+
+    switch (node->kind) {
+    case RegexKind::Concat:
+        return simplifyConcat(children);
+    case RegexKind::Union:
+        return simplifyUnion(children);
+    case RegexKind::Star:
+        if (children[0]->kind == RegexKind::Star) {
+            return children[0]; // (r*)* 与 r* 等价
         }
+        return makeNode(RegexKind::Star, children);
+    case RegexKind::Group:
+        return children[0]; // 只判定是否匹配时括号没有意义
+    default:
+        return node;
+    }
+}
+
+// 按前序遍历（即左括号出现的顺序）给捕获组编号，返回组数
+int numberGroups(const RegexPtr& node, int count = 0) {
+    if (!node) return count;
+    if (node->kind == RegexKind::Group) {
+        node->group = ++count;
+    }
+    for (const auto& child : node->children) {
+        count = numberGroups(child, count);
+    }
+    return count;
+}
+
+/// @brief 正规式 -> 语法树，正规式非法时返回 nullptr
+/// @param simplify 为 true 时化简（并去掉捕获组）；为 false 时保留原始结构并给捕获组编号
+RegexPtr parseRegex(const std::string& regex, bool simplify = true) {
+    std::string withConcat = insertConcatOperators(regex);
+    std::string postfix = toPostfix(withConcat);
+    // std::cerr << "postfix: " << postfix << "\n";
+
+    RegexPtr ast = parsePostfix(postfix);
+    if (simplify) {
+        return simplifyRegex(ast);
+    }
+    numberGroups(ast);
+    return ast;
+}
+
+// -------------------- 第四步：Thompson 构造 NFA --------------------
+
+class NFAFactory {
+public:
+    // simplify 为 false 时跳过语法树化简，按原始结构构造 NFA，并在捕获组的首尾 epsilon 边上打标签
+    explicit NFAFactory(bool simplify = true) : nextId(1), simplify(simplify) {}
+
+    NFA buildFromRegex(const std::string& regex) {
+        RegexPtr ast = parseRegex(regex, simplify);
 
         NFA nfa;
-        if (!st.empty()) {
-            NFAFragment finalFrag = st.top();
+        if (ast) {
+            NFAFragment finalFrag = buildFromAST(ast);
             nfa.start = finalFrag.start;
             nfa.accept = finalFrag.accept;
         }
         nfa.states = allNodes;
         nfa.alphabet = alphabet;
 		nfa.regex = regex;
+        nfa.groupCount = groupCount;
         return nfa;
     }
 
 private:
     int nextId;
+    bool simplify;
+    int groupCount = 0;
     std::vector<NFANode*> allNodes;
     std::set<char> alphabet;
 
@@ -229,6 +676,34 @@ private:
         return node;
     }
 
+    NFAFragment buildFromAST(const RegexPtr& node) {
+        switch (node->kind) {
+        case RegexKind::Literal:
+            return buildLiteral(node->symbol);
+        case RegexKind::Class:
+            return buildClass(node->ranges);
+        case RegexKind::Concat: {
+            NFAFragment frag = buildFromAST(node->children[0]);
+            for (size_t i = 1; i < node->children.size(); ++i) {
+                frag = buildConcat(frag, buildFromAST(node->children[i]));
+            }
+            return frag;
+        }
+        case RegexKind::Union: {
+            std::vector<NFAFragment> branches;
+            for (const auto& child : node->children) {
+                branches.push_back(buildFromAST(child));
+            }
+            return buildUnion(branches);
+        }
+        case RegexKind::Group:
+            return buildGroup(buildFromAST(node->children[0]), node->group);
+        case RegexKind::Star:
+        default:
+            return buildStar(buildFromAST(node->children[0]));
+        }
+    }
+
     NFAFragment buildLiteral(char c) {
         NFANode* s = newNode();
         NFANode* t = newNode();
@@ -237,18 +712,112 @@ private:
         return { s, t };
     }
 
+    // 字符类：ASCII 部分只需两个状态，每个字符一条边；
+    // 多字节部分拆成 UTF-8 字节序列区间，从后往前构造，公共后缀共用同一组状态
+    NFAFragment buildClass(const std::vector<CodePointRange>& ranges) {
+        NFANode* s = newNode();
+        NFANode* t = newNode();
+        std::map<std::tuple<int, int, NFANode*>, NFANode*> suffixCache;
+
+        for (const auto& r : ranges) {
+            std::vector<std::vector<std::pair<int, int>>> sequences;
+            splitUTF8Range(r.first, r.second, sequences);
+            for (const auto& seq : sequences) {
+                NFANode* target = t;
+                for (size_t k = seq.size() - 1; k > 0; --k) {
+                    auto key = std::make_tuple(seq[k].first, seq[k].second, target);
+                    auto it = suffixCache.find(key);
+                    if (it == suffixCache.end()) {
+                        NFANode* n = newNode();
+                        addByteRange(n, seq[k].first, seq[k].second, target);
+                        it = suffixCache.emplace(key, n).first;
+                    }
+                    target = it->second;
+                }
+                addByteRange(s, seq[0].first, seq[0].second, target);
+            }
+        }
+        return { s, t };
+    }
+
+    void addByteRange(NFANode* from, int lo, int hi, NFANode* to) {
+        for (int b = lo; b <= hi; ++b) {
+            from->edges.push_back({ (char)b, to });
+            alphabet.insert((char)b);
+        }
+    }
+
+    /// @brief 把码点区间 [lo, hi] 拆成若干 UTF-8 字节序列，每个序列逐字节给出取值区间
+    /// 先按编码长度和代理区切分，再把区间对齐到 6 位边界，使各字节区间可以独立组合
+    static void splitUTF8Range(int lo, int hi, std::vector<std::vector<std::pair<int, int>>>& out) {
+        if (lo > hi) return;
+        // 跳过代理区 D800-DFFF
+        if (lo <= 0xDFFF && hi >= 0xD800) {
+            splitUTF8Range(lo, 0xD7FF, out);
+            splitUTF8Range(0xE000, hi, out);
+            return;
+        }
+        // 按编码长度的边界切分
+        static const int lengthLimits[] = { 0x7F, 0x7FF, 0xFFFF };
+        for (int limit : lengthLimits) {
+            if (lo <= limit && hi > limit) {
+                splitUTF8Range(lo, limit, out);
+                splitUTF8Range(limit + 1, hi, out);
+                return;
+            }
+        }
+        if (hi < 0x80) {
+            out.push_back({ { lo, hi } });
+            return;
+        }
+        // 对齐：除最高字节外，每个后续字节都必须取满 80-BF 或只取一个固定前缀
+        for (int n = 1; n < 4; ++n) {
+            int m = (1 << (6 * n)) - 1;
+            if ((lo & ~m) != (hi & ~m)) {
+                if ((lo & m) != 0) {
+                    splitUTF8Range(lo, lo | m, out);
+                    splitUTF8Range((lo | m) + 1, hi, out);
+                    return;
+                }
+                if ((hi & m) != m) {
+                    splitUTF8Range(lo, (hi & ~m) - 1, out);
+                    splitUTF8Range(hi & ~m, hi, out);
+                    return;
+                }
+            }
+        }
+        std::string a = encodeUTF8(lo);
+        std::string b = encodeUTF8(hi);
+        std::vector<std::pair<int, int>> seq;
+        for (size_t k = 0; k < a.size(); ++k) {
+            seq.push_back({ static_cast<unsigned char>(a[k]), static_cast<unsigned char>(b[k]) });
+        }
+        out.push_back(seq);
+    }
+
     NFAFragment buildConcat(const NFAFragment& left, const NFAFragment& right) {
         left.accept->edges.push_back({ '\0', right.start });
         return { left.start, right.accept };
     }
 
-    NFAFragment buildUnion(const NFAFragment& left, const NFAFragment& right) {
+    // n 元选择共用一对首尾状态
+    NFAFragment buildUnion(const std::vector<NFAFragment>& branches) {
+        NFANode* s = newNode();
+        NFANode* t = newNode();
+        for (const auto& b : branches) {
+            s->edges.push_back({ '\0', b.start });
+            b.accept->edges.push_back({ '\0', t });
+        }
+        return { s, t };
+    }
+
+    // 捕获组：进入时记录开始标签，离开时记录结束标签
+    NFAFragment buildGroup(const NFAFragment& frag, int group) {
         NFANode* s = newNode();
         NFANode* t = newNode();
-        s->edges.push_back({ '\0', left.start });
-        s->edges.push_back({ '\0', right.start });
-        left.accept->edges.push_back({ '\0', t });
-        right.accept->edges.push_back({ '\0', t });
+        s->edges.push_back({ '\0', frag.start, 2 * (group - 1) });
+        frag.accept->edges.push_back({ '\0', t, 2 * (group - 1) + 1 });
+        groupCount = std::max(groupCount, group);
         return { s, t };
     }
 
@@ -279,9 +848,10 @@ void printNFA(const NFA& nfa, std::ostream& out) {
             out << node->id << "->" << e.to->id << ":";
             if (e.symbol == '\0') {
                 out << "epsilon";
+                if (e.tag >= 0) out << "/T" << e.tag;
             }
             else {
-                out << e.symbol;
+                out << symbolToString(e.symbol);
             }
             out << "\n";
         }
@@ -293,7 +863,7 @@ void printNFA(const NFA& nfa, std::ostream& out) {
     bool first = true;
     for (char c : nfa.alphabet) {
         if (!first) out << ", ";
-        out << c;
+        out << symbolToString(c);
         first = false;
     }
     out << "\n";
@@ -441,6 +1011,189 @@ DFA nfaToDfa(const NFA& nfa) {
     return dfa;
 }
 
+// -------------------- NFA -> DFA (并行子集构造) --------------------
+// 单个大正规式的子集构造在 nfaToDfa 中只用一个线程做 BFS。
+// 这里每个工作线程从自己的双端队列取待处理的 DFA 状态，对每个字母独立计算 move 和闭包，
+// 新子集登记到分段加锁的子集表中；队列空了就去别的线程队列的另一端窃取任务。
+// 线程调度使得发现顺序不确定，最后按 BFS 重新编号，保证输出与 nfaToDfa 完全一致。
+
+struct SubsetRecord {
+    const std::set<int>* nfaStates = nullptr; // 指向子集表中的键，map 结点地址稳定
+    bool isAccept = false;
+    std::map<char, SubsetRecord*> trans;      // 只由处理该状态的线程写入
+};
+
+// 分段加锁的子集表：按子集的哈希值选段，不同段的插入互不阻塞
+class StripedSubsetTable {
+public:
+    explicit StripedSubsetTable(size_t stripeCount) : stripes(stripeCount) {}
+
+    /// @brief 查找或登记子集
+    /// @return 子集对应的记录，以及是否为新登记的
+    std::pair<SubsetRecord*, bool> intern(const std::set<int>& subset, int acceptIdx) {
+        Stripe& stripe = stripes[hashOf(subset) % stripes.size()];
+        std::lock_guard<std::mutex> lock(stripe.m);
+        auto it = stripe.table.find(subset);
+        if (it != stripe.table.end()) {
+            return { &it->second, false };
+        }
+        auto inserted = stripe.table.emplace(subset, SubsetRecord());
+        SubsetRecord* rec = &inserted.first->second;
+        rec->nfaStates = &inserted.first->first;
+        rec->isAccept = subset.count(acceptIdx) > 0;
+        return { rec, true };
+    }
+
+private:
+    struct Stripe {
+        std::mutex m;
+        std::map<std::set<int>, SubsetRecord> table;
+    };
+    std::vector<Stripe> stripes;
+
+    static size_t hashOf(const std::set<int>& subset) {
+        size_t h = subset.size();
+        for (int x : subset) {
+            h ^= (size_t)x + 0x9e3779b9 + (h << 6) + (h >> 2);
+        }
+        return h;
+    }
+};
+
+// 工作窃取队列：所有者在尾部存取，窃取者从头部拿
+struct WorkDeque {
+    std::mutex m;
+    std::deque<SubsetRecord*> items;
+
+    void push(SubsetRecord* rec) {
+        std::lock_guard<std::mutex> lock(m);
+        items.push_back(rec);
+    }
+    SubsetRecord* pop() {
+        std::lock_guard<std::mutex> lock(m);
+        if (items.empty()) return nullptr;
+        SubsetRecord* rec = items.back();
+        items.pop_back();
+        return rec;
+    }
+    SubsetRecord* steal() {
+        std::lock_guard<std::mutex> lock(m);
+        if (items.empty()) return nullptr;
+        SubsetRecord* rec = items.front();
+        items.pop_front();
+        return rec;
+    }
+};
+
+/// @brief 多线程子集构造
+/// @param threads 工作线程数，不大于 1 时退化为 nfaToDfa
+/// @return 与 nfaToDfa 编号相同的 DFA
+DFA nfaToDfaParallel(const NFA& nfa, unsigned threads) {
+    if (threads <= 1 || !nfa.start || !nfa.accept) {
+        return nfaToDfa(nfa);
+    }
+
+    std::map<NFANode*, int> nodeIndex;
+    for (size_t i = 0; i < nfa.states.size(); ++i) {
+        nodeIndex[nfa.states[i]] = (int)i;
+    }
+    int startIdx = nodeIndex[nfa.start];
+    int acceptIdx = nodeIndex[nfa.accept];
+
+    StripedSubsetTable table(threads * 16);
+    std::vector<WorkDeque> deques(threads);
+    std::atomic<int> pending(0); // 已登记但尚未处理完的状态数
+    std::atomic<int> queued(0);  // 已放入队列但尚未被取走的状态数
+    std::atomic<int> sleepers(0);
+    std::mutex idleMutex;
+    std::condition_variable wake;
+
+    // 前沿较窄时空闲线程在条件变量上睡眠，不占用 CPU。入队的线程接着会处理自己队列里的状态，
+    // 所以只在队列中多于一个状态时才唤醒别的线程。
+    // 通知前先取一次锁，等待方在检查条件与进入睡眠之间不会错过通知
+    auto notify = [&](bool all) {
+        if (sleepers.load() == 0) return;
+        { std::lock_guard<std::mutex> lock(idleMutex); }
+        if (all) wake.notify_all();
+        else wake.notify_one();
+    };
+
+    std::set<int> startSet = epsilonClosure({ startIdx }, nfa.states, nodeIndex);
+    SubsetRecord* startRec = table.intern(startSet, acceptIdx).first;
+    pending = 1;
+    queued = 1;
+    deques[0].push(startRec);
+
+    auto worker = [&](unsigned self) {
+        while (true) {
+            SubsetRecord* rec = deques[self].pop();
+            for (unsigned k = 1; !rec && k < threads; ++k) {
+                rec = deques[(self + k) % threads].steal();
+            }
+            if (!rec) {
+                if (pending.load() == 0) return;
+                std::unique_lock<std::mutex> lock(idleMutex);
+                ++sleepers;
+                wake.wait(lock, [&] { return queued.load() > 1 || pending.load() == 0; });
+                --sleepers;
+                continue;
+            }
+            --queued;
+
+            for (char c : nfa.alphabet) {
+                std::set<int> moveSet = moveOnSymbol(*rec->nfaStates, c, nfa.states, nodeIndex);
+                if (moveSet.empty()) continue;
+                std::set<int> targetSet = epsilonClosure(moveSet, nfa.states, nodeIndex);
+
+                auto interned = table.intern(targetSet, acceptIdx);
+                if (interned.second) {
+                    ++pending;
+                    deques[self].push(interned.first);
+                    if (++queued > 1) notify(false);
+                }
+                rec->trans[c] = interned.first;
+            }
+            if (--pending == 0) notify(true);
+        }
+    };
+
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; ++t) {
+        pool.emplace_back(worker, t);
+    }
+    for (auto& th : pool) {
+        th.join();
+    }
+
+    // 按 BFS（字母序）重新编号，得到确定的输出
+    DFA dfa;
+    dfa.alphabet = nfa.alphabet;
+    std::map<SubsetRecord*, int> recToId;
+    std::vector<SubsetRecord*> order;
+    recToId[startRec] = 0;
+    order.push_back(startRec);
+    for (size_t head = 0; head < order.size(); ++head) {
+        for (const auto& kv : order[head]->trans) {
+            if (recToId.count(kv.second)) continue;
+            recToId[kv.second] = (int)order.size();
+            order.push_back(kv.second);
+        }
+    }
+
+    dfa.states.resize(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        DFAState& st = dfa.states[i];
+        st.id = (int)i;
+        st.isAccept = order[i]->isAccept;
+        st.nfaStates = *order[i]->nfaStates;
+        for (const auto& kv : order[i]->trans) {
+            st.trans[kv.first] = recToId[kv.second];
+        }
+    }
+    dfa.start = 0;
+    return dfa;
+}
+
 // -------------------- DFA 最小化（表填充法） --------------------
 
 struct MinDFAState {
@@ -473,6 +1226,77 @@ struct DSU {
     }
 };
 
+/// @brief 表填充法：求 M 个状态的等价类，按每类第一个状态的下标顺序编号
+/// initiallyDistinct(i, j)：i、j 一开始就可区分（如接受与否不同）
+/// target(i, c)：i 在 c 上的目标状态，没有转移时为 -1
+/// transitionCompatible(i, j, c)：除目标外，i、j 在 c 上的转移是否相容（如寄存器操作相同）
+template <typename Distinct, typename Target, typename Compatible>
+std::vector<int> tableFillClasses(int M, const std::set<char>& alphabet, Distinct initiallyDistinct,
+    Target target, Compatible transitionCompatible, int& classCount) {
+    // 二维表，上三角有效
+    std::vector<std::vector<bool>> diff(M, std::vector<bool>(M, false));
+    for (int i = 0; i < M; ++i) {
+        for (int j = i + 1; j < M; ++j) {
+            if (initiallyDistinct(i, j)) diff[i][j] = true;
+        }
+    }
+
+    // 迭代细化：某个字母上转移不相容，或目标已可区分，则 i、j 可区分
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (int i = 0; i < M; ++i) {
+            for (int j = i + 1; j < M; ++j) {
+                if (diff[i][j])
+                    continue;
+                bool mark = false;
+                for (char c : alphabet) {
+                    int p = target(i, c);
+                    int q = target(j, c);
+                    if (p == q && p == -1)
+                        continue;
+                    if (p == -1 || q == -1 || !transitionCompatible(i, j, c)) {
+                        mark = true; // 一个有边，一个没边，或转移本身不同
+                        break;
+                    }
+                    if (p != q && diff[std::min(p, q)][std::max(p, q)]) {
+                        mark = true;
+                        break;
+                    }
+                }
+                if (mark) {
+                    diff[i][j] = true;
+                    changed = true;
+                }
+            }
+        }
+    }
+
+    // 用并查集合并不可区分的状态，再给每个等价类分配新的编号
+    DSU dsu(M);
+    for (int i = 0; i < M; ++i) {
+        for (int j = i + 1; j < M; ++j) {
+            if (!diff[i][j]) dsu.unite(i, j);
+        }
+    }
+    std::map<int, int> rootToNew;
+    std::vector<int> classOf(M, -1);
+    for (int i = 0; i < M; ++i) {
+        int r = dsu.find(i);
+        auto it = rootToNew.find(r);
+        if (it == rootToNew.end()) {
+            int id = (int)rootToNew.size();
+            rootToNew[r] = id;
+            classOf[i] = id;
+        }
+        else {
+            classOf[i] = it->second;
+        }
+    }
+    classCount = (int)rootToNew.size();
+    return classOf;
+}
+
 MinDFA minimizeDFA(const DFA& dfa) {
     MinDFA mdfa;
     mdfa.alphabet = dfa.alphabet;
@@ -575,90 +1399,16 @@ MinDFA minimizeDFA(const DFA& dfa) {
         }
     }
 
-    // 5. 表填充法标记“可区分”的状态对
-    // 二维表，M 为总状态数，上三角有效
-    std::vector<std::vector<bool>> diff(M, std::vector<bool>(M, false));
-
-    // 5.1 初始：接受 / 非接受
-    for (int i = 0; i < M; ++i) {
-        for (int j = i + 1; j < M; ++j) {
-            if (isAccept[i] != isAccept[j]) {
-                // 也就是最开始分成的两个集合
-                diff[i][j] = true;
-            }
-        }
-    }
-
-    // 5.2 迭代细化
-    bool changed = true;
-    while (changed) {
-        changed = false;
-        for (int i = 0; i < M; ++i) {
-            for (int j = i + 1; j < M; ++j) {
-                if (diff[i][j]) 
-                    continue;
-				// 说明 i,j 目前不可区分
-                // 对所有字母检查 δ(i,a)、δ(j,a) 是否已经区分
-                bool mark = false;
-                // 遍历所有文字
-                for (char c : mdfa.alphabet) {
-                    auto it1 = trans[i].find(c);
-                    auto it2 = trans[j].find(c);
-                    int p = (it1 == trans[i].end()) ? -1 : it1->second;
-                    int q = (it2 == trans[j].end()) ? -1 : it2->second;
-                    if (p == -1 || q == -1) {
-                        // 正常情况：如果有 sink，则不会出现 -1
-                        if (p != q) {
-                            mark = true; // 一个有边，一个没边 -> 可区分
-                            break;
-                        }
-                        else {
-                            continue;
-                        }
-                    }
-                    if (p == q) 
-						continue; // 转移到同一状态，继续检查下一个字母
-                    int a = std::min(p, q);
-					int b = std::max(p, q); // 确保访问上三角
-                    if (diff[a][b]) {
-                        mark = true;
-                        break;
-                    }
-                }
-                if (mark) {
-                    diff[i][j] = true;
-                    changed = true;
-                }
-            }
-        }
-    }
-
-    // 6. 用并查集合并“不可区分”的状态
-    DSU dsu(M);
-    for (int i = 0; i < M; ++i) {
-        for (int j = i + 1; j < M; ++j) {
-            if (!diff[i][j]) {
-                dsu.unite(i, j);
-            }
-        }
-    }
-
-    // 7. 给每个等价类分配新的编号
-    std::map<int, int> rootToNew;
-    std::vector<int> classOf(M, -1);
+    // 5~7. 表填充法求等价类：初始按接受 / 非接受区分，转移只看目标
     int newCount = 0;
-    for (int i = 0; i < M; ++i) {
-        int r = dsu.find(i);
-        auto it = rootToNew.find(r);
-        if (it == rootToNew.end()) {
-            rootToNew[r] = newCount;
-            classOf[i] = newCount;
-            ++newCount;
-        }
-        else {
-            classOf[i] = it->second;
-        }
-    }
+    std::vector<int> classOf = tableFillClasses(M, mdfa.alphabet,
+        [&](int i, int j) { return isAccept[i] != isAccept[j]; },
+        [&](int i, char c) {
+            auto it = trans[i].find(c);
+            return it == trans[i].end() ? -1 : it->second;
+        },
+        [](int, int, char) { return true; },
+        newCount);
 
     mdfa.states.resize(newCount);
     for (int i = 0; i < newCount; ++i) {
@@ -688,6 +1438,31 @@ MinDFA minimizeDFA(const DFA& dfa) {
     return mdfa;
 }
 
+// 反向 BFS 求能到达接受状态的状态（活状态），其余状态（包括补全时加入的陷阱状态）不可能再接受
+std::vector<bool> liveStates(const MinDFA& mdfa) {
+    int N = (int)mdfa.states.size();
+    std::vector<std::vector<int>> preds(N);
+    std::vector<bool> live(N, false);
+    std::queue<int> q;
+    for (const auto& st : mdfa.states) {
+        for (const auto& kv : st.trans) preds[kv.second].push_back(st.id);
+        if (st.isAccept) {
+            live[st.id] = true;
+            q.push(st.id);
+        }
+    }
+    while (!q.empty()) {
+        int s = q.front(); q.pop();
+        for (int p : preds[s]) {
+            if (!live[p]) {
+                live[p] = true;
+                q.push(p);
+            }
+        }
+    }
+    return live;
+}
+
 // -------------------- 输出最简 DFA --------------------
 
 void printMinDFA(const MinDFA& dfa, std::ostream& out) {
@@ -715,7 +1490,7 @@ void printMinDFA(const MinDFA& dfa, std::ostream& out) {
         for (const auto& kv : st.trans) {
             char c = kv.first;
             int to = kv.second;
-            out << (st.id + 1) << "->" << (to + 1) << ":" << c << "\n";
+            out << (st.id + 1) << "->" << (to + 1) << ":" << symbolToString(c) << "\n";
         }
     }
 
@@ -723,34 +1498,1643 @@ void printMinDFA(const MinDFA& dfa, std::ostream& out) {
     first = true;
     for (char c : dfa.alphabet) {
         if (!first) out << ", ";
-        out << c;
+        out << symbolToString(c);
         first = false;
     }
     out << "\n";
 }
 
+// -------------------- 已编译 DFA 的布尔运算（惰性乘积构造） --------------------
+// 从 (startA, startB) 出发只生成可达的状态对，缺失的转移视为进入死状态 -1。
+// 组合已编译好的过滤器比把正规式拼起来重新编译便宜得多。
+
+enum class ProductOp {
+    Intersection, // A 且 B
+    Difference,   // A 且非 B
+    Union         // A 或 B
+};
+
+// 把 MinDFA 转回 DFA，以便复用 minimizeDFA
+DFA toDFA(const MinDFA& mdfa) {
+    DFA dfa;
+    dfa.start = mdfa.start;
+    dfa.alphabet = mdfa.alphabet;
+    for (const auto& st : mdfa.states) {
+        DFAState ns;
+        ns.id = st.id;
+        ns.isAccept = st.isAccept;
+        ns.trans = st.trans;
+        dfa.states.push_back(ns);
+    }
+    return dfa;
+}
+
+/// @brief 两个 DFA 的乘积
+/// @param minimize 为 true 时对乘积结果再做一次最小化
+MinDFA productDFA(const MinDFA& a, const MinDFA& b, ProductOp op, bool minimize = false) {
+    MinDFA result;
+    result.alphabet = a.alphabet;
+    result.alphabet.insert(b.alphabet.begin(), b.alphabet.end());
+
+    auto accepts = [&](int p, int q) {
+        bool inA = p >= 0 && a.states[p].isAccept;
+        bool inB = q >= 0 && b.states[q].isAccept;
+        switch (op) {
+        case ProductOp::Intersection: return inA && inB;
+        case ProductOp::Difference:   return inA && !inB;
+        default:                      return inA || inB;
+        }
+    };
+    // 状态对从此不可能再接受时，不必生成
+    auto isDead = [&](int p, int q) {
+        switch (op) {
+        case ProductOp::Intersection: return p < 0 || q < 0;
+        case ProductOp::Difference:   return p < 0;
+        default:                      return p < 0 && q < 0;
+        }
+    };
+    // 不能再到达接受状态的一侧（如 minimizeDFA 补上的陷阱状态）按 -1 处理，
+    // 这样 isDead 才能在交、差中尽早剪掉整个状态对
+    std::vector<bool> liveA = liveStates(a);
+    std::vector<bool> liveB = liveStates(b);
+    auto step = [](const MinDFA& m, const std::vector<bool>& live, int s, char c) {
+        if (s < 0) return -1;
+        auto it = m.states[s].trans.find(c);
+        if (it == m.states[s].trans.end() || !live[it->second]) return -1;
+        return it->second;
+    };
+
+    int startA = a.states.empty() || !liveA[a.start] ? -1 : a.start;
+    int startB = b.states.empty() || !liveB[b.start] ? -1 : b.start;
+    if (isDead(startA, startB)) return result;
+
+    std::map<std::pair<int, int>, int> pairToId;
+    std::vector<std::pair<int, int>> idToPair;
+    std::queue<int> q;
+
+    auto intern = [&](int p, int s) {
+        auto key = std::make_pair(p, s);
+        auto it = pairToId.find(key);
+        if (it != pairToId.end()) return it->second;
+        int id = (int)result.states.size();
+        MinDFAState ns;
+        ns.id = id;
+        ns.isAccept = accepts(p, s);
+        result.states.push_back(ns);
+        pairToId[key] = id;
+        idToPair.push_back(key);
+        q.push(id);
+        return id;
+    };
+
+    result.start = intern(startA, startB);
+    while (!q.empty()) {
+        int id = q.front(); q.pop();
+        int p = idToPair[id].first;
+        int s = idToPair[id].second;
+        for (char c : result.alphabet) {
+            int np = step(a, liveA, p, c);
+            int ns = step(b, liveB, s, c);
+            if (isDead(np, ns)) continue;
+            int to = intern(np, ns);
+            result.states[id].trans[c] = to;
+        }
+    }
+
+    if (minimize) {
+        return minimizeDFA(toDFA(result));
+    }
+    return result;
+}
+
+MinDFA intersectDFA(const MinDFA& a, const MinDFA& b, bool minimize = false) {
+    return productDFA(a, b, ProductOp::Intersection, minimize);
+}
+
+MinDFA differenceDFA(const MinDFA& a, const MinDFA& b, bool minimize = false) {
+    return productDFA(a, b, ProductOp::Difference, minimize);
+}
+
+MinDFA unionDFA(const MinDFA& a, const MinDFA& b, bool minimize = false) {
+    return productDFA(a, b, ProductOp::Union, minimize);
+}
+
+/// @brief 补集，相对于 a 的字母表与 extraAlphabet 的并
+/// minimizeDFA 会为缺失的转移补上 sink，得到完全 DFA 后翻转接受状态即可；
+/// 最小完全 DFA 翻转接受状态后仍是最小的
+MinDFA complementDFA(const MinDFA& a, const std::set<char>& extraAlphabet = {}) {
+    DFA dfa = toDFA(a);
+    dfa.alphabet.insert(extraAlphabet.begin(), extraAlphabet.end());
+    if (dfa.states.empty()) {
+        // 空语言：补一个非接受的起始状态，由 minimizeDFA 补全为 sink
+        DFAState empty;
+        dfa.states.push_back(empty);
+        dfa.start = 0;
+    }
+
+    MinDFA complete = minimizeDFA(dfa);
+    for (auto& st : complete.states) {
+        st.isAccept = !st.isAccept;
+    }
+    return complete;
+}
+
+// -------------------- DFA 等价 / 包含判定（Hopcroft-Karp） --------------------
+// 直接在两个 DFA 上做并查集双模拟，不需要先最小化任何一方。
+// 两个自动机的状态放在同一个并查集里：A 的状态为 0..nA-1，B 的状态为 nA..nA+nB-1，
+// 另加一个公共的死状态 nA+nB，用来补全缺失的转移。
+
+struct EquivalenceResult {
+    bool holds = true;           // 等价 / 包含是否成立
+    std::string counterexample;  // 不成立时的最短反例串
+};
+
+// 把两个 DFA 看成一个不相交并，便于统一地取转移和接受标记
+template <typename AutomatonA, typename AutomatonB>
+struct DFAPairView {
+    const AutomatonA& a;
+    const AutomatonB& b;
+    int nA, nB, dead;
+
+    DFAPairView(const AutomatonA& _a, const AutomatonB& _b)
+        : a(_a), b(_b), nA((int)_a.states.size()), nB((int)_b.states.size()), dead(nA + nB) {}
+
+    int startA() const { return a.states.empty() ? dead : a.start; }
+    int startB() const { return b.states.empty() ? dead : nA + b.start; }
+
+    bool isAccept(int s) const {
+        if (s == dead) return false;
+        if (s < nA) return a.states[s].isAccept;
+        return b.states[s - nA].isAccept;
+    }
+
+    int step(int s, char c) const {
+        if (s == dead) return dead;
+        if (s < nA) {
+            auto it = a.states[s].trans.find(c);
+            return it == a.states[s].trans.end() ? dead : it->second;
+        }
+        auto it = b.states[s - nA].trans.find(c);
+        return it == b.states[s - nA].trans.end() ? dead : nA + it->second;
+    }
+
+    std::set<char> alphabet() const {
+        std::set<char> sigma = a.alphabet;
+        sigma.insert(b.alphabet.begin(), b.alphabet.end());
+        return sigma;
+    }
+};
+
+// BFS 中的状态对，parent/symbol 用于回溯出反例串
+struct StatePair {
+    int p, q;
+    int parent;
+    char symbol;
+};
+
+std::string traceCounterexample(const std::vector<StatePair>& pairs, int idx) {
+    std::string word;
+    while (pairs[idx].parent >= 0) {
+        word.push_back(pairs[idx].symbol);
+        idx = pairs[idx].parent;
+    }
+    return std::string(word.rbegin(), word.rend());
+}
+
+/// @brief 判定 L(a) == L(b)
+/// 按 BFS 顺序合并状态对，第一个接受性不同的状态对即给出最短反例，随即停止
+template <typename AutomatonA, typename AutomatonB>
+EquivalenceResult checkEquivalence(const AutomatonA& a, const AutomatonB& b) {
+    DFAPairView<AutomatonA, AutomatonB> view(a, b);
+    std::set<char> sigma = view.alphabet();
+    EquivalenceResult result;
+
+    DSU dsu(view.dead + 1);
+    std::vector<StatePair> pairs;
+    size_t head = 0;
+
+    auto visit = [&](int p, int q, int parent, char symbol) -> bool {
+        if (dsu.find(p) == dsu.find(q)) return true;
+        dsu.unite(p, q);
+        pairs.push_back({ p, q, parent, symbol });
+        if (view.isAccept(p) != view.isAccept(q)) {
+            result.holds = false;
+            result.counterexample = traceCounterexample(pairs, (int)pairs.size() - 1);
+            return false;
+        }
+        return true;
+    };
+
+    if (!visit(view.startA(), view.startB(), -1, '\0')) return result;
+
+    while (head < pairs.size()) {
+        int idx = (int)head++;
+        for (char c : sigma) {
+            int p = view.step(pairs[idx].p, c);
+            int q = view.step(pairs[idx].q, c);
+            if (!visit(p, q, idx, c)) return result;
+        }
+    }
+    return result;
+}
+
+/// @brief 判定 L(a) ⊆ L(b)
+/// 包含关系不满足传递合并，不能用并查集剪枝，这里在可达状态对上做 BFS，
+/// 遇到 a 接受而 b 不接受的状态对即停止，得到最短反例
+template <typename AutomatonA, typename AutomatonB>
+EquivalenceResult checkInclusion(const AutomatonA& a, const AutomatonB& b) {
+    DFAPairView<AutomatonA, AutomatonB> view(a, b);
+    std::set<char> sigma = view.alphabet();
+    EquivalenceResult result;
+
+    std::set<std::pair<int, int>> seen;
+    std::vector<StatePair> pairs;
+    size_t head = 0;
+
+    auto visit = [&](int p, int q, int parent, char symbol) -> bool {
+        if (!seen.insert({ p, q }).second) return true;
+        pairs.push_back({ p, q, parent, symbol });
+        if (view.isAccept(p) && !view.isAccept(q)) {
+            result.holds = false;
+            result.counterexample = traceCounterexample(pairs, (int)pairs.size() - 1);
+            return false;
+        }
+        return true;
+    };
+
+    if (!visit(view.startA(), view.startB(), -1, '\0')) return result;
+
+    while (head < pairs.size()) {
+        int idx = (int)head++;
+        // 两边都已进入死状态时，后续不可能再出现 a 接受的情况
+        if (pairs[idx].p == view.dead) continue;
+        for (char c : sigma) {
+            int p = view.step(pairs[idx].p, c);
+            int q = view.step(pairs[idx].q, c);
+            if (!visit(p, q, idx, c)) return result;
+        }
+    }
+    return result;
+}
+
+void printCounterexample(const EquivalenceResult& r, std::ostream& out) {
+    out << "  counterexample: " << (r.counterexample.empty() ? "epsilon" : r.counterexample) << "\n";
+}
+
+// 输入文件中每两行为一组，判定两条正规式的关系
+void printEquivalence(const std::string& regexA, const std::string& regexB, std::ostream& out) {
+    NFAFactory factoryA, factoryB;
+    DFA dfaA = nfaToDfa(factoryA.buildFromRegex(regexA));
+    DFA dfaB = nfaToDfa(factoryB.buildFromRegex(regexB));
+
+    out << "--------------------------------------------------\n";
+    out << "# A: " << regexA << "\n";
+    out << "# B: " << regexB << "\n";
+
+    EquivalenceResult eq = checkEquivalence(dfaA, dfaB);
+    out << "A == B: " << (eq.holds ? "YES" : "NO") << "\n";
+    if (eq.holds) return;
+    printCounterexample(eq, out);
+
+    EquivalenceResult ab = checkInclusion(dfaA, dfaB);
+    out << "A <= B: " << (ab.holds ? "YES" : "NO") << "\n";
+    if (!ab.holds) printCounterexample(ab, out);
+
+    EquivalenceResult ba = checkInclusion(dfaB, dfaA);
+    out << "B <= A: " << (ba.holds ? "YES" : "NO") << "\n";
+    if (!ba.holds) printCounterexample(ba, out);
+}
+
+// -------------------- 在大段文本中查找匹配（字面量预过滤） --------------------
+// 大段文本中绝大多数位置都不可能是匹配的起点。编译时先从 DFA 和语法树中提取：
+// 必需的字面量前缀、可能的首字节集合、匹配中必然出现的字面量子串，
+// 查找时用 memchr（库实现通常是 SIMD 的）跳到候选位置，只在候选位置上运行 DFA。
+
+// 平铺的转移表：字节先映射到等价类（在所有状态上转移都相同的字节属于同一类），
+// 每行只存 classCount 项，next[s * classCount + byteClass[byte]]，-1 表示死状态。
+// 常见正规式只有十几个类，一行远小于 256 项，多个状态的行可以落在同一条缓存行里。
+// 不可能再到达接受状态的状态（如 minimizeDFA 补上的 sink）也记为 -1，扫描可以提前结束
+struct DFATable {
+    int start = -1;              // -1 表示空语言
+    int stateCount = 0;
+    int classCount = 1;
+    std::vector<unsigned char> byteClass = std::vector<unsigned char>(256, 0);
+    std::vector<int> next;
+    std::vector<char> accept;
+
+    int step(int s, unsigned char b) const {
+        return next[(size_t)s * classCount + byteClass[b]];
+    }
+};
+
+DFATable buildTable(const MinDFA& mdfa) {
+    DFATable table;
+    int N = (int)mdfa.states.size();
+    if (N == 0) return table;
+
+    std::vector<bool> live = liveStates(mdfa);
+
+    // 只保留活状态，保持原有的相对编号
+    std::vector<int> newId(N, -1);
+    for (int i = 0; i < N; ++i) {
+        if (live[i]) newId[i] = table.stateCount++;
+    }
+    table.start = newId[mdfa.start];
+    std::vector<int> full((size_t)table.stateCount * 256, -1);
+    table.accept.assign(table.stateCount, 0);
+    for (const auto& st : mdfa.states) {
+        int from = newId[st.id];
+        if (from < 0) continue;
+        table.accept[from] = st.isAccept;
+        for (const auto& kv : st.trans) {
+            full[(size_t)from * 256 + static_cast<unsigned char>(kv.first)] = newId[kv.second];
+        }
+    }
+
+    // 按各字节在所有状态上的转移列划分等价类，类按第一个字节的顺序编号
+    std::map<std::vector<int>, int> columnToClass;
+    for (int b = 0; b < 256; ++b) {
+        std::vector<int> column(table.stateCount);
+        for (int i = 0; i < table.stateCount; ++i) column[i] = full[(size_t)i * 256 + b];
+        auto it = columnToClass.emplace(column, (int)columnToClass.size()).first;
+        table.byteClass[b] = (unsigned char)it->second;
+    }
+    table.classCount = (int)columnToClass.size();
+    table.next.assign((size_t)table.stateCount * table.classCount, -1);
+    for (int i = 0; i < table.stateCount; ++i) {
+        for (int b = 0; b < 256; ++b) {
+            table.next[(size_t)i * table.classCount + table.byteClass[b]] = full[(size_t)i * 256 + b];
+        }
+    }
+    return table;
+}
+
+// 编译正规式并生成匹配用的转移表
+DFATable compileTable(const std::string& regex) {
+    NFAFactory factory;
+    return buildTable(minimizeDFA(nfaToDfa(factory.buildFromRegex(regex))));
+}
+
+// 按 '\n' 把文本切成行，返回各行的 (起点, 长度)，行尾的 '\r' 不计入长度
+std::vector<std::pair<size_t, size_t>> splitLines(const std::string& text) {
+    std::vector<std::pair<size_t, size_t>> lines;
+    size_t begin = 0;
+    while (begin < text.size()) {
+        size_t end = text.find('\n', begin);
+        if (end == std::string::npos) end = text.size();
+        size_t len = end - begin;
+        if (len > 0 && text[end - 1] == '\r') --len;
+        lines.push_back({ begin, len });
+        begin = end + 1;
+    }
+    return lines;
+}
+
+// 从语法树中找出匹配必然包含的最长字面量子串：
+// 连接中相邻的定长字面量（单字节或单个码点）可以拼接，选择和闭包中的部分不是必需的
+std::string requiredLiteral(const RegexPtr& node) {
+    if (!node) return "";
+    auto fixedBytes = [](const RegexPtr& n, std::string& bytes) {
+        if (n->kind == RegexKind::Literal) {
+            bytes = std::string(1, n->symbol);
+            return true;
+        }
+        if (n->kind == RegexKind::Class && n->ranges.size() == 1 &&
+            n->ranges[0].first == n->ranges[0].second) {
+            bytes = encodeUTF8(n->ranges[0].first);
+            return true;
+        }
+        return false;
+    };
+
+    std::string single;
+    if (fixedBytes(node, single)) return single;
+    if (node->kind != RegexKind::Concat) return "";
+
+    std::string best, run, bytes;
+    for (const auto& child : node->children) {
+        if (fixedBytes(child, bytes)) {
+            run += bytes;
+            if (run.size() > best.size()) best = run;
+        }
+        else {
+            run.clear();
+            // 子树必然被匹配，其内部的必需串同样是必需的
+            std::string inner = requiredLiteral(child);
+            if (inner.size() > best.size()) best = inner;
+        }
+    }
+    return best;
+}
+
+// 粗略的字节频率等级，越大越常见；在字面量中选最罕见的字节交给 memchr
+int byteFrequencyRank(unsigned char b) {
+    if (b == ' ' || (b != 0 && std::strchr("etaoinsrhl", b))) return 4; // strchr 也会匹配结尾的 '\0'
+    if (std::islower(b) || b == '\n') return 3;
+    if (std::isdigit(b) || std::isupper(b)) return 2;
+    if (b < 0x80 && std::ispunct(b)) return 1;
+    return 0;
+}
+
+struct Match {
+    size_t begin, end; // 匹配区间 [begin, end)
+};
+
+class RegexSearcher {
+public:
+    explicit RegexSearcher(const std::string& regex) {
+        table = compileTable(regex);
+        analyze(parseRegex(regex));
+    }
+
+    const std::string& literalPrefix() const { return prefix; }
+    const std::string& requiredSubstring() const { return required; }
+
+    /// @brief 找出所有不重叠的最左最长匹配；空匹配不报告
+    std::vector<Match> findAll(const char* data, size_t size) const {
+        std::vector<Match> matches;
+        if (table.start < 0) return matches;
+
+        size_t pos = 0;
+        size_t requiredAt = 0;     // 下一个必需子串的位置
+        bool requiredKnown = false;
+        while (pos < size) {
+            // 从 pos 开始的匹配必然在 pos 之后包含必需子串，找不到就可以结束
+            if (!required.empty() && (!requiredKnown || requiredAt < pos)) {
+                requiredAt = findLiteral(data, size, pos, required, requiredRare);
+                requiredKnown = true;
+                if (requiredAt == std::string::npos) break;
+            }
+
+            size_t cand = nextCandidate(data, size, pos);
+            if (cand == std::string::npos) break;
+
+            size_t end = longestMatchAt(data, size, cand);
+            if (end > cand) {
+                matches.push_back({ cand, end });
+                pos = end;
+            }
+            else {
+                pos = cand + 1;
+            }
+        }
+        return matches;
+    }
+
+private:
+    DFATable table;
+    std::string prefix;        // 所有匹配共同的字面量前缀
+    size_t prefixRare = 0;     // prefix 中最罕见字节的下标
+    std::string required;      // 所有匹配都包含的字面量子串（不是前缀时使用）
+    size_t requiredRare = 0;
+    std::vector<bool> firstByte = std::vector<bool>(256, false);
+    std::vector<unsigned char> firstBytes;
+
+    void analyze(const RegexPtr& ast) {
+        if (table.start < 0) return;
+
+        // 1. 前缀：从起始状态出发，只要状态不接受且只有一个活的出边，下一个字节就是确定的
+        int s = table.start;
+        std::set<int> visited;
+        while (!table.accept[s] && visited.insert(s).second) {
+            int only = -1;
+            for (int b = 0; b < 256; ++b) {
+                if (table.step(s, (unsigned char)b) < 0) continue;
+                if (only >= 0) { only = -2; break; }
+                only = b;
+            }
+            if (only < 0) break;
+            prefix.push_back((char)only);
+            s = table.step(s, (unsigned char)only);
+        }
+        prefixRare = rarestIndex(prefix);
+
+        // 2. 首字节集合
+        for (int b = 0; b < 256; ++b) {
+            if (table.step(table.start, (unsigned char)b) >= 0) {
+                firstByte[b] = true;
+                firstBytes.push_back((unsigned char)b);
+            }
+        }
+
+        // 3. 必需子串，已被前缀覆盖时不再单独查找
+        required = requiredLiteral(ast);
+        if (required.size() <= prefix.size()) required.clear();
+        requiredRare = rarestIndex(required);
+    }
+
+    static size_t rarestIndex(const std::string& lit) {
+        size_t best = 0;
+        for (size_t i = 1; i < lit.size(); ++i) {
+            if (byteFrequencyRank(lit[i]) < byteFrequencyRank(lit[best])) best = i;
+        }
+        return best;
+    }
+
+    // 用 memchr 定位罕见字节，再用 memcmp 校验整个字面量
+    static size_t findLiteral(const char* data, size_t size, size_t from,
+        const std::string& lit, size_t rare) {
+        if (lit.size() > size) return std::string::npos;
+        size_t last = size - lit.size(); // 字面量起点的上界
+        size_t scan = from + rare;
+        while (from <= last) {
+            const void* hit = std::memchr(data + scan, lit[rare], last + rare + 1 - scan);
+            if (!hit) return std::string::npos;
+            size_t at = (const char*)hit - data - rare;
+            if (std::memcmp(data + at, lit.data(), lit.size()) == 0) return at;
+            from = at + 1;
+            scan = from + rare;
+        }
+        return std::string::npos;
+    }
+
+    // 下一个可能的匹配起点
+    size_t nextCandidate(const char* data, size_t size, size_t from) const {
+        if (!prefix.empty()) {
+            return findLiteral(data, size, from, prefix, prefixRare);
+        }
+        if (table.accept[table.start]) {
+            return from; // 可以匹配空串，每个位置都是候选
+        }
+        if (firstBytes.size() == 1) {
+            const void* hit = std::memchr(data + from, firstBytes[0], size - from);
+            return hit ? (size_t)((const char*)hit - data) : std::string::npos;
+        }
+        for (size_t i = from; i < size; ++i) {
+            if (firstByte[static_cast<unsigned char>(data[i])]) return i;
+        }
+        return std::string::npos;
+    }
+
+    // 从 begin 开始运行 DFA，返回最长匹配的终点；没有匹配时返回 begin
+    size_t longestMatchAt(const char* data, size_t size, size_t begin) const {
+        int s = table.start;
+        size_t lastEnd = begin;
+        for (size_t i = begin; i < size; ++i) {
+            s = table.step(s, static_cast<unsigned char>(data[i]));
+            if (s < 0) break;
+            if (table.accept[s]) lastEnd = i + 1;
+        }
+        return lastEnd;
+    }
+};
+
+// 对文本文件逐条正规式查找，输出每个匹配的区间 [begin, end) 和内容
+void printSearch(const std::string& regex, const std::string& text, std::ostream& out) {
+    RegexSearcher searcher(regex);
+    std::vector<Match> matches = searcher.findAll(text.data(), text.size());
+
+    auto escaped = [](const std::string& bytes) {
+        std::string r;
+        for (char c : bytes) {
+            r += static_cast<unsigned char>(c) >= 0x80 ? std::string(1, c) : symbolToString(c);
+        }
+        return r;
+    };
+
+    out << "--------------------------------------------------\n";
+    out << "# Search: " << regex << "\n";
+    out << "# Prefix: " << escaped(searcher.literalPrefix())
+        << "  Required: " << escaped(searcher.requiredSubstring()) << "\n";
+    for (const auto& m : matches) {
+        out << m.begin << "-" << m.end << ":" << escaped(text.substr(m.begin, m.end - m.begin)) << "\n";
+    }
+    out << "# Matches: " << matches.size() << "\n";
+}
+
+// -------------------- 带标签的 DFA（TDFA）：无回溯的子匹配提取 --------------------
+// 捕获组的首尾在 NFA 的 epsilon 边上打标签。子集构造时，DFA 状态是按优先级排序的 NFA 状态列表
+// （每个 NFA 状态即一个“线程”），每个线程为每个标签保留一个寄存器；
+// 转移上附带寄存器操作：从源线程复制，或置为当前位置。
+// 优先级按 Thompson 构造中 epsilon 边的先后（选择取左、闭包优先继续），即最左贪婪语义。
+// 匹配时只需一次线性扫描，在接受状态取优先级最高的接受线程的寄存器作为各组的位置。
+
+const int TAG_SET_POS = -1; // 寄存器置为当前位置
+const int TAG_UNSET = -2;   // 寄存器置为未设置
+
+struct TDFATransition {
+    int to = -1;
+    // ops[k] 给出目标状态寄存器 k 的来源：>= 0 为源状态的寄存器号，或 TAG_SET_POS / TAG_UNSET
+    std::vector<int> ops;
+};
+
+struct TDFAState {
+    int id = 0;
+    int registerCount = 0;  // 线程数 * 标签数
+    int finalThread = -1;   // 接受时读取哪个线程的寄存器，-1 表示非接受
+    std::map<char, TDFATransition> trans;
+};
+
+struct TaggedDFA {
+    int start = 0;
+    std::vector<int> startOps;  // 起始状态寄存器的初值
+    std::vector<TDFAState> states;
+    std::set<char> alphabet;
+    int tagCount = 0;
+    int groupCount = 0;
+
+    /// @brief 整串匹配并提取捕获组
+    /// @param groups 匹配成功时为各组区间 [begin, end)，第 0 组为整串；未参与匹配的组为 (-1, -1)
+    bool match(const std::string& text, std::vector<std::pair<int, int>>& groups) const {
+        if (states.empty()) return false;
+
+        std::vector<int> cur, next;
+        applyOps(startOps, cur, next, 0);
+        cur.swap(next);
+
+        int s = start;
+        for (size_t i = 0; i < text.size(); ++i) {
+            auto it = states[s].trans.find(text[i]);
+            if (it == states[s].trans.end()) return false;
+            applyOps(it->second.ops, cur, next, (int)i + 1);
+            cur.swap(next);
+            s = it->second.to;
+        }
+
+        int f = states[s].finalThread;
+        if (f < 0) return false;
+        groups.assign(groupCount + 1, { -1, -1 });
+        groups[0] = { 0, (int)text.size() };
+        for (int g = 1; g <= groupCount; ++g) {
+            int b = cur[f * tagCount + 2 * (g - 1)];
+            int e = cur[f * tagCount + 2 * (g - 1) + 1];
+            if (b >= 0 && e >= 0) groups[g] = { b, e };
+        }
+        return true;
+    }
+
+private:
+    static void applyOps(const std::vector<int>& ops, const std::vector<int>& cur,
+        std::vector<int>& next, int pos) {
+        next.resize(ops.size());
+        for (size_t k = 0; k < ops.size(); ++k) {
+            int op = ops[k];
+            next[k] = op >= 0 ? cur[op] : (op == TAG_SET_POS ? pos : -1);
+        }
+    }
+};
+
+/// @brief 由带标签的 NFA（NFAFactory(false) 构造）生成 TDFA
+TaggedDFA buildTaggedDFA(const NFA& nfa) {
+    TaggedDFA tdfa;
+    tdfa.alphabet = nfa.alphabet;
+    tdfa.groupCount = nfa.groupCount;
+    tdfa.tagCount = 2 * nfa.groupCount;
+    const int T = tdfa.tagCount;
+    if (!nfa.start || !nfa.accept) return tdfa;
+
+    std::map<NFANode*, int> nodeIndex;
+    for (size_t i = 0; i < nfa.states.size(); ++i) {
+        nodeIndex[nfa.states[i]] = (int)i;
+    }
+    int acceptIdx = nodeIndex[nfa.accept];
+
+    // 只保留有字符转移的 NFA 状态和接受状态作为线程，其余状态只是 epsilon 路径上的中转
+    std::vector<bool> keep(nfa.states.size(), false);
+    for (size_t i = 0; i < nfa.states.size(); ++i) {
+        keep[i] = ((int)i == acceptIdx);
+        for (const auto& e : nfa.states[i]->edges) {
+            if (e.symbol != '\0') keep[i] = true;
+        }
+    }
+
+    // 按优先级做 epsilon 闭包：深度优先，先到先得；路径上经过的标签置为当前位置
+    struct Step {
+        std::vector<int> threads;  // 新状态的线程（NFA 状态下标）
+        std::vector<int> ops;      // 新状态寄存器的来源
+        std::set<int> visited;
+        std::vector<int> pathTags;
+    };
+    std::function<void(Step&, int, int)> closure = [&](Step& st, int u, int srcThread) {
+        if (!st.visited.insert(u).second) return;
+        if (keep[u]) {
+            st.threads.push_back(u);
+            for (int t = 0; t < T; ++t) {
+                bool set = std::find(st.pathTags.begin(), st.pathTags.end(), t) != st.pathTags.end();
+                st.ops.push_back(set ? TAG_SET_POS : (srcThread >= 0 ? srcThread * T + t : TAG_UNSET));
+            }
+        }
+        for (const auto& e : nfa.states[u]->edges) {
+            if (e.symbol != '\0') continue;
+            if (e.tag >= 0) st.pathTags.push_back(e.tag);
+            closure(st, nodeIndex.at(e.to), srcThread);
+            if (e.tag >= 0) st.pathTags.pop_back();
+        }
+    };
+
+    std::map<std::vector<int>, int> threadsToId;
+    std::vector<std::vector<int>> idToThreads;
+    std::queue<int> q;
+
+    auto intern = [&](const std::vector<int>& threads) {
+        auto it = threadsToId.find(threads);
+        if (it != threadsToId.end()) return it->second;
+        int id = (int)tdfa.states.size();
+        TDFAState ns;
+        ns.id = id;
+        ns.registerCount = (int)threads.size() * T;
+        for (size_t k = 0; k < threads.size(); ++k) {
+            if (threads[k] == acceptIdx) {
+                ns.finalThread = (int)k; // 线程按优先级排列，取第一个
+                break;
+            }
+        }
+        tdfa.states.push_back(ns);
+        threadsToId[threads] = id;
+        idToThreads.push_back(threads);
+        q.push(id);
+        return id;
+    };
+
+    Step init;
+    closure(init, nodeIndex[nfa.start], -1);
+    tdfa.startOps = init.ops;
+    tdfa.start = intern(init.threads);
+
+    while (!q.empty()) {
+        int sid = q.front(); q.pop();
+        std::vector<int> threads = idToThreads[sid];
+        for (char c : tdfa.alphabet) {
+            Step st;
+            for (size_t k = 0; k < threads.size(); ++k) {
+                for (const auto& e : nfa.states[threads[k]]->edges) {
+                    if (e.symbol == c) closure(st, nodeIndex.at(e.to), (int)k);
+                }
+            }
+            if (st.threads.empty()) continue;
+            TDFATransition tr;
+            tr.to = intern(st.threads);
+            tr.ops = st.ops;
+            tdfa.states[sid].trans[c] = tr;
+        }
+    }
+    return tdfa;
+}
+
+/// @brief TDFA 最小化（表填充法）
+/// 与 minimizeDFA 共用 tableFillClasses，只是两个状态等价还要求：寄存器数和接受时读取的线程相同，
+/// 且每个字母上的寄存器操作完全相同，这样合并后各组的位置不变
+TaggedDFA minimizeTaggedDFA(const TaggedDFA& tdfa) {
+    int M = (int)tdfa.states.size();
+    if (M == 0) return tdfa;
+    const auto& st = tdfa.states;
+
+    int classCount = 0;
+    std::vector<int> classOf = tableFillClasses(M, tdfa.alphabet,
+        [&](int i, int j) {
+            return st[i].finalThread != st[j].finalThread || st[i].registerCount != st[j].registerCount;
+        },
+        [&](int i, char c) {
+            auto it = st[i].trans.find(c);
+            return it == st[i].trans.end() ? -1 : it->second.to;
+        },
+        [&](int i, int j, char c) { return st[i].trans.at(c).ops == st[j].trans.at(c).ops; },
+        classCount);
+
+    TaggedDFA result = tdfa;
+    result.states.assign(classCount, TDFAState());
+    for (int i = 0; i < M; ++i) {
+        TDFAState& ns = result.states[classOf[i]];
+        ns.id = classOf[i];
+        ns.registerCount = st[i].registerCount;
+        ns.finalThread = st[i].finalThread;
+        for (const auto& kv : st[i].trans) {
+            TDFATransition tr = kv.second;
+            tr.to = classOf[tr.to];
+            ns.trans[kv.first] = tr;
+        }
+    }
+    result.start = classOf[tdfa.start];
+    return result;
+}
+
+// 对文本文件的每一行做整行匹配，输出各捕获组的区间
+void printCaptures(const std::string& regex, const std::string& text, std::ostream& out) {
+    NFAFactory factory(false);
+    TaggedDFA raw = buildTaggedDFA(factory.buildFromRegex(regex));
+    TaggedDFA tdfa = minimizeTaggedDFA(raw);
+
+    out << "--------------------------------------------------\n";
+    out << "# Match: " << regex << "\n";
+    out << "# TDFA states: " << tdfa.states.size() << " (before minimization: " << raw.states.size() << ")\n";
+
+    for (const auto& l : splitLines(text)) {
+        std::string line = text.substr(l.first, l.second);
+        std::vector<std::pair<int, int>> groups;
+        out << line << ": ";
+        if (!tdfa.match(line, groups)) {
+            out << "NO\n";
+            continue;
+        }
+        out << "YES";
+        for (size_t g = 0; g < groups.size(); ++g) {
+            out << " " << g << ":";
+            if (groups[g].first < 0) {
+                out << "-";
+            }
+            else {
+                out << "[" << groups[g].first << "," << groups[g].second << ")"
+                    << line.substr(groups[g].first, groups[g].second - groups[g].first);
+            }
+        }
+        out << "\n";
+    }
+}
+
+// -------------------- 最简 DFA 即时编译为 x86-64 机器码 --------------------
+// 查表匹配每读一个字节都要做一次依赖前一次结果的访存。JIT 把每个状态编译成一段代码（直接线程化）：
+// 转移稀疏的状态用比较 / 跳转序列，转移稠密的状态用小跳转表，自环转移排在最前面，
+// 使 1->1:a 这类自环退化为一个紧凑的扫描循环。
+// 非 x86-64 平台或无法分配可执行内存时，自动退回查表匹配。
+
+// 查表整串匹配
+bool matchTable(const DFATable& table, const char* data, size_t size) {
+    int s = table.start;
+    if (s < 0) return false;
+    for (size_t i = 0; i < size; ++i) {
+        s = table.step(s, static_cast<unsigned char>(data[i]));
+        if (s < 0) return false;
+    }
+    return table.accept[s] != 0;
+}
+
+class JitDFA {
+public:
+    explicit JitDFA(const DFATable& t) : table(t) {
+#ifdef DFA_JIT_X64
+        compile();
+#endif
+    }
+
+    ~JitDFA() {
+#ifdef DFA_JIT_X64
+        if (code) {
+#ifdef _WIN32
+            VirtualFree(code, 0, MEM_RELEASE);
+#else
+            munmap(code, codeSize);
+#endif
+        }
+#endif
+    }
+
+    JitDFA(const JitDFA&) = delete;
+    JitDFA& operator=(const JitDFA&) = delete;
+
+    bool compiled() const { return fn != nullptr; }
+    size_t compiledSize() const { return codeSize; }
+
+    /// @brief 整串匹配；没有编译出机器码时用查表匹配
+    bool match(const char* data, size_t size) const {
+        if (fn) {
+            const unsigned char* p = reinterpret_cast<const unsigned char*>(data);
+            return fn(p, p + size) != 0;
+        }
+        return matchTable(table, data, size);
+    }
+
+private:
+    using MatchFn = int (*)(const unsigned char* begin, const unsigned char* end);
+
+    DFATable table;
+    void* code = nullptr;
+    size_t codeSize = 0;
+    MatchFn fn = nullptr;
+
+#ifdef DFA_JIT_X64
+    // 超过这么多个字节区间的状态改用跳转表
+    static const int DENSE_RANGES = 8;
+
+    std::vector<unsigned char> buf;
+    std::vector<size_t> labels;                       // 标号 -> 代码偏移
+    std::vector<std::pair<size_t, int>> relFixups;    // rel32 的位置、目标标号
+    struct TableFixup { size_t at; size_t base; int label; };
+    std::vector<TableFixup> tableFixups;              // 跳转表项：目标相对表首的偏移
+
+    void emit(std::initializer_list<int> bytes) {
+        for (int b : bytes) buf.push_back((unsigned char)b);
+    }
+    void emit32(int v) {
+        for (int k = 0; k < 4; ++k) buf.push_back((unsigned char)((unsigned)v >> (8 * k)));
+    }
+    void patch32(size_t at, int v) {
+        for (int k = 0; k < 4; ++k) buf[at + k] = (unsigned char)((unsigned)v >> (8 * k));
+    }
+    int newLabel() {
+        labels.push_back(0);
+        return (int)labels.size() - 1;
+    }
+    void bind(int label) { labels[label] = buf.size(); }
+    // 条件 / 无条件跳转：opcode 之后跟 rel32
+    void jumpTo(std::initializer_list<int> opcode, int label) {
+        emit(opcode);
+        relFixups.push_back({ buf.size(), label });
+        emit32(0);
+    }
+
+    // 状态 s 的出边按目标合并成连续的字节区间
+    struct ByteRange { int lo, hi, to; };
+    std::vector<ByteRange> rangesOf(int s) const {
+        std::vector<ByteRange> ranges;
+        for (int b = 0; b < 256; ++b) {
+            int to = table.step(s, (unsigned char)b);
+            if (to < 0) continue;
+            if (!ranges.empty() && ranges.back().hi == b - 1 && ranges.back().to == to) {
+                ranges.back().hi = b;
+            }
+            else {
+                ranges.push_back({ b, b, to });
+            }
+        }
+        return ranges;
+    }
+
+    // al / eax 中是当前字节，命中区间则跳到 label
+    void emitRangeTest(const ByteRange& r, int label) {
+        if (r.lo == r.hi) {
+            emit({ 0x3C, r.lo });                  // cmp al, imm8
+            jumpTo({ 0x0F, 0x84 }, label);         // je
+        }
+        else {
+            emit({ 0x8D, 0x88 }); emit32(-r.lo);   // lea ecx, [rax - lo]
+            emit({ 0x81, 0xF9 }); emit32(r.hi - r.lo); // cmp ecx, hi - lo
+            jumpTo({ 0x0F, 0x86 }, label);         // jbe
+        }
+    }
+
+    void compile() {
+        int N = table.stateCount;
+        std::vector<int> stateLabel(N);
+        for (int s = 0; s < N; ++s) stateLabel[s] = newLabel();
+        int fail = newLabel();
+
+        // 入口：把两个参数放到 r8 (当前指针) / r9 (末尾)，这两个寄存器在两种调用约定下都是易失的
+#ifdef _WIN32
+        emit({ 0x49, 0x89, 0xC8 });                // mov r8, rcx
+        emit({ 0x49, 0x89, 0xD1 });                // mov r9, rdx
+#else
+        emit({ 0x49, 0x89, 0xF8 });                // mov r8, rdi
+        emit({ 0x49, 0x89, 0xF1 });                // mov r9, rsi
+#endif
+        if (table.start < 0) {
+            jumpTo({ 0xE9 }, fail);
+        }
+        else {
+            jumpTo({ 0xE9 }, stateLabel[table.start]);
+        }
+
+        for (int s = 0; s < N; ++s) {
+            int atEnd = newLabel();
+            bind(stateLabel[s]);
+            emit({ 0x4D, 0x39, 0xC8 });            // cmp r8, r9
+            jumpTo({ 0x0F, 0x84 }, atEnd);         // je atEnd
+            emit({ 0x41, 0x0F, 0xB6, 0x00 });      // movzx eax, byte [r8]
+            emit({ 0x49, 0xFF, 0xC0 });            // inc r8
+
+            std::vector<ByteRange> ranges = rangesOf(s);
+            std::vector<ByteRange> loops, others;
+            for (const auto& r : ranges) {
+                (r.to == s ? loops : others).push_back(r);
+            }
+            // 自环放在最前，命中时直接回到本状态开头
+            for (const auto& r : loops) {
+                emitRangeTest(r, stateLabel[s]);
+            }
+
+            if ((int)others.size() > DENSE_RANGES) {
+                emitJumpTable(others, stateLabel, fail);
+            }
+            else {
+                for (const auto& r : others) {
+                    emitRangeTest(r, stateLabel[r.to]);
+                }
+                jumpTo({ 0xE9 }, fail);
+            }
+
+            bind(atEnd);
+            emit({ 0xB8 }); emit32(table.accept[s] ? 1 : 0); // mov eax, accept
+            emit({ 0xC3 });                        // ret
+        }
+
+        bind(fail);
+        emit({ 0x31, 0xC0 });                      // xor eax, eax
+        emit({ 0xC3 });                            // ret
+
+        for (const auto& f : relFixups) {
+            patch32(f.first, (int)(labels[f.second] - (f.first + 4)));
+        }
+        for (const auto& f : tableFixups) {
+            patch32(f.at, (int)(labels[f.label] - f.base));
+        }
+        install();
+    }
+
+    // 跳转表覆盖 [最小字节, 最大字节]，表项为目标相对表首的 32 位偏移
+    void emitJumpTable(const std::vector<ByteRange>& ranges, const std::vector<int>& stateLabel, int fail) {
+        int lo = ranges.front().lo;
+        int hi = ranges.back().hi;
+        emit({ 0x2D }); emit32(lo);                // sub eax, lo
+        emit({ 0x3D }); emit32(hi - lo);           // cmp eax, hi - lo
+        jumpTo({ 0x0F, 0x87 }, fail);              // ja fail
+        emit({ 0x48, 0x8D, 0x0D });                // lea rcx, [rip + 表首]
+        size_t leaDisp = buf.size();
+        emit32(0);
+        emit({ 0x48, 0x63, 0x04, 0x81 });          // movsxd rax, dword [rcx + rax*4]
+        emit({ 0x48, 0x01, 0xC8 });                // add rax, rcx
+        emit({ 0xFF, 0xE0 });                      // jmp rax
+
+        size_t base = buf.size();
+        patch32(leaDisp, (int)(base - (leaDisp + 4)));
+        std::vector<int> target(hi - lo + 1, fail);
+        for (const auto& r : ranges) {
+            for (int b = r.lo; b <= r.hi; ++b) target[b - lo] = stateLabel[r.to];
+        }
+        for (int label : target) {
+            tableFixups.push_back({ buf.size(), base, label });
+            emit32(0);
+        }
+    }
+
+    // 复制到可执行内存：先以读写方式分配，写入后改为只读可执行
+    void install() {
+        codeSize = buf.size();
+#ifdef _WIN32
+        void* mem = VirtualAlloc(nullptr, codeSize, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        if (!mem) return;
+        std::memcpy(mem, buf.data(), codeSize);
+        DWORD old;
+        if (!VirtualProtect(mem, codeSize, PAGE_EXECUTE_READ, &old)) {
+            VirtualFree(mem, 0, MEM_RELEASE);
+            return;
+        }
+#else
+        void* mem = mmap(nullptr, codeSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (mem == MAP_FAILED) return;
+        std::memcpy(mem, buf.data(), codeSize);
+        if (mprotect(mem, codeSize, PROT_READ | PROT_EXEC) != 0) {
+            munmap(mem, codeSize);
+            return;
+        }
+#endif
+        code = mem;
+        fn = reinterpret_cast<MatchFn>(mem);
+        buf.clear();
+        buf.shrink_to_fit();
+    }
+#endif
+};
+
+// 对文本文件的各行分别用查表匹配和 JIT 匹配，比较耗时并核对结果
+void printBenchmark(const std::string& regex, const std::string& text, std::ostream& out) {
+    DFATable table = compileTable(regex);
+    JitDFA jit(table);
+    std::vector<std::pair<size_t, size_t>> lines = splitLines(text);
+
+    // 重复若干遍，使总扫描量约为 64MB
+    size_t reps = std::max<size_t>(1, ((size_t)64 << 20) / std::max<size_t>(1, text.size()));
+
+    auto timeIt = [&](bool useJit, size_t& matched) {
+        auto t0 = std::chrono::steady_clock::now();
+        matched = 0;
+        for (size_t r = 0; r < reps; ++r) {
+            for (const auto& l : lines) {
+                const char* p = text.data() + l.first;
+                matched += useJit ? jit.match(p, l.second) : matchTable(table, p, l.second);
+            }
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(t1 - t0).count();
+    };
+
+    size_t matchedTable = 0, matchedJit = 0;
+    double tableMs = timeIt(false, matchedTable);
+    double jitMs = timeIt(true, matchedJit);
+
+    // 匹配计数写到输出文件，可以与样例核对；耗时与 JIT 信息随机器而变，写到 std::cerr
+    out << "--------------------------------------------------\n";
+    out << "# Bench: " << regex << "\n";
+    out << "lines: " << lines.size() << " x " << reps << "\n";
+    out << "matched: " << matchedTable / reps << " per pass\n";
+    if (matchedTable != matchedJit) {
+        out << "Error: JIT and table matcher disagree.\n";
+    }
+
+    std::cerr << "# Bench: " << regex << "\n";
+    if (jit.compiled()) {
+        std::cerr << "# JIT: " << jit.compiledSize() << " bytes of x86-64 code for " << table.stateCount << " states\n";
+    }
+    else {
+        std::cerr << "# JIT: unavailable, using table matcher\n";
+    }
+    std::cerr << "table: " << tableMs << " ms, matched " << matchedTable << "\n";
+    std::cerr << "jit:   " << jitMs << " ms, matched " << matchedJit << "\n";
+}
+
+// -------------------- 按剖析结果重排状态编号，并序列化转移表 --------------------
+// minimizeDFA 按并查集根的顺序编号，nfaToDfa 按 BFS 顺序编号，都不考虑匹配时哪些转移是热的。
+// 多模式的大自动机转移表超出 L1 时，热状态的行分散在表中会频繁缺失缓存。
+// 这里先在样本语料上统计各状态的访问次数与转移次数，再把热状态与其最常去的后继排在相邻的行。
+// 行按字节等价类压缩后只有 classCount * 4 字节，相邻的几行共用一条 64 字节的缓存行，重排才有意义。
+
+struct DFAProfile {
+    std::vector<unsigned long long> visits;                   // 状态访问次数
+    std::vector<std::map<int, unsigned long long>> edges;     // edges[s][t]：s -> t 的转移次数
+};
+
+// 在语料的每一行上做整行匹配，统计访问与转移
+DFAProfile profileTable(const DFATable& table, const std::vector<std::string>& corpus) {
+    DFAProfile prof;
+    prof.visits.assign(table.stateCount, 0);
+    prof.edges.assign(table.stateCount, std::map<int, unsigned long long>());
+    if (table.start < 0) return prof;
+
+    for (const auto& line : corpus) {
+        int s = table.start;
+        ++prof.visits[s];
+        for (char c : line) {
+            int t = table.step(s, static_cast<unsigned char>(c));
+            if (t < 0) break;
+            ++prof.edges[s][t];
+            ++prof.visits[t];
+            s = t;
+        }
+    }
+    return prof;
+}
+
+/// @brief 计算新的状态顺序（order[新编号] = 旧编号）
+/// 按 Pettis-Hansen 的做法成链：转移按执行次数从高到低处理，若源状态是某条链的尾、
+/// 目标状态是另一条链的头，就把两条链首尾相接；最后各链按其中最热状态的访问次数排列。
+/// 这样最热的转移尽量落在相邻的两行上。语料中没访问到的状态保持原有相对顺序
+std::vector<int> hotLayout(const DFATable& table, const DFAProfile& prof) {
+    int N = table.stateCount;
+
+    struct Edge { unsigned long long count; int from, to; };
+    std::vector<Edge> edges;
+    for (int s = 0; s < N; ++s) {
+        for (const auto& kv : prof.edges[s]) {
+            if (kv.first != s) edges.push_back({ kv.second, s, kv.first });
+        }
+    }
+    std::stable_sort(edges.begin(), edges.end(), [](const Edge& a, const Edge& b) {
+        return a.count > b.count;
+    });
+
+    // 每条链用并查集维护，链内用 next 指针串起来
+    DSU chains(N);
+    std::vector<int> nextInChain(N, -1), prevInChain(N, -1);
+    for (const auto& e : edges) {
+        if (nextInChain[e.from] != -1 || prevInChain[e.to] != -1) continue;
+        if (chains.find(e.from) == chains.find(e.to)) continue; // 会成环
+        nextInChain[e.from] = e.to;
+        prevInChain[e.to] = e.from;
+        chains.unite(e.from, e.to);
+    }
+
+    // 链的热度取链中最热状态的访问次数
+    std::vector<unsigned long long> heat(N, 0);
+    for (int s = 0; s < N; ++s) {
+        int r = chains.find(s);
+        heat[r] = std::max(heat[r], prof.visits[s]);
+    }
+    std::vector<int> heads;
+    for (int s = 0; s < N; ++s) {
+        if (prevInChain[s] == -1) heads.push_back(s);
+    }
+    std::stable_sort(heads.begin(), heads.end(), [&](int a, int b) {
+        return heat[chains.find(a)] > heat[chains.find(b)];
+    });
+
+    std::vector<int> order;
+    for (int h : heads) {
+        for (int s = h; s != -1; s = nextInChain[s]) order.push_back(s);
+    }
+    return order;
+}
+
+// 按 order 重新编号转移表
+DFATable relayoutTable(const DFATable& table, const std::vector<int>& order) {
+    int N = table.stateCount;
+    std::vector<int> newId(N);
+    for (int i = 0; i < N; ++i) newId[order[i]] = i;
+
+    DFATable result;
+    result.stateCount = N;
+    result.start = table.start < 0 ? -1 : newId[table.start];
+    result.classCount = table.classCount;
+    result.byteClass = table.byteClass;
+    result.next.assign((size_t)N * table.classCount, -1);
+    result.accept.assign(N, 0);
+    for (int i = 0; i < N; ++i) {
+        int old = order[i];
+        result.accept[i] = table.accept[old];
+        for (int c = 0; c < table.classCount; ++c) {
+            int to = table.next[(size_t)old * table.classCount + c];
+            result.next[(size_t)i * table.classCount + c] = to < 0 ? -1 : newId[to];
+        }
+    }
+    return result;
+}
+
+// 序列化格式（小端）：魔数 "DFATBL2\0"，int32 状态数，int32 起始状态，int32 字节类数，
+// 256 字节的字节到类映射，每个状态 1 字节接受标记，随后按状态顺序每行 classCount 个 int32 转移（-1 为死状态）
+const char TABLE_MAGIC[8] = { 'D', 'F', 'A', 'T', 'B', 'L', '2', '\0' };
+
+void writeInt32(std::ostream& out, int v) {
+    for (int k = 0; k < 4; ++k) out.put((char)((unsigned)v >> (8 * k)));
+}
+
+bool readInt32(std::istream& in, int& v) {
+    unsigned u = 0;
+    for (int k = 0; k < 4; ++k) {
+        int c = in.get();
+        if (c == EOF) return false;
+        u |= (unsigned)c << (8 * k);
+    }
+    v = (int)u;
+    return true;
+}
+
+bool writeTable(const DFATable& table, std::ostream& out) {
+    out.write(TABLE_MAGIC, sizeof(TABLE_MAGIC));
+    writeInt32(out, table.stateCount);
+    writeInt32(out, table.start);
+    writeInt32(out, table.classCount);
+    out.write(reinterpret_cast<const char*>(table.byteClass.data()), 256);
+    out.write(table.accept.data(), table.accept.size());
+    for (int v : table.next) writeInt32(out, v);
+    return (bool)out;
+}
+
+bool readTable(std::istream& in, DFATable& table) {
+    char magic[sizeof(TABLE_MAGIC)];
+    if (!in.read(magic, sizeof(magic)) || std::memcmp(magic, TABLE_MAGIC, sizeof(magic)) != 0) {
+        return false;
+    }
+    DFATable t;
+    if (!readInt32(in, t.stateCount) || !readInt32(in, t.start) || t.stateCount < 0 ||
+        t.start < -1 || t.start >= t.stateCount) {
+        return false;
+    }
+    if (!readInt32(in, t.classCount) || t.classCount < 1 || t.classCount > 256 ||
+        !in.read(reinterpret_cast<char*>(t.byteClass.data()), 256)) {
+        return false;
+    }
+    for (unsigned char c : t.byteClass) {
+        if (c >= t.classCount) return false;
+    }
+    t.accept.resize(t.stateCount);
+    if (!in.read(t.accept.data(), t.stateCount)) return false;
+    t.next.resize((size_t)t.stateCount * t.classCount);
+    for (auto& v : t.next) {
+        if (!readInt32(in, v) || v < -1 || v >= t.stateCount) return false;
+    }
+    table = t;
+    return true;
+}
+
+// 编译每行正规式，按语料剖析结果（如果有）重排后写出 <prefix><行号>.dfa
+void printEmit(const std::string& regex, int index, const std::string& prefix,
+    const std::vector<std::string>& corpus, std::ostream& out) {
+    DFATable table = compileTable(regex);
+
+    out << "--------------------------------------------------\n";
+    out << "# Emit: " << regex << "\n";
+    out << "# Table: " << table.stateCount << " states x " << table.classCount << " byte classes, "
+        << table.classCount * sizeof(int) << " bytes per row\n";
+    if (!corpus.empty()) {
+        // 局部性：执行的非自环转移中，目标行与当前行首地址相隔的 64 字节缓存行数（按执行次数加权平均）
+        size_t rowBytes = table.classCount * sizeof(int);
+        auto lineDistance = [rowBytes](const DFAProfile& prof) {
+            unsigned long long total = 0;
+            double distance = 0;
+            for (size_t s = 0; s < prof.edges.size(); ++s) {
+                for (const auto& kv : prof.edges[s]) {
+                    if (kv.first == (int)s) continue;
+                    long long from = (long long)(s * rowBytes / 64);
+                    long long to = (long long)((size_t)kv.first * rowBytes / 64);
+                    total += kv.second;
+                    distance += (double)kv.second * std::abs(to - from);
+                }
+            }
+            return total ? distance / total : 0.0;
+        };
+        // 在语料上重复整行匹配约 16MB，返回耗时
+        size_t corpusBytes = 0;
+        for (const auto& line : corpus) corpusBytes += line.size() + 1;
+        size_t reps = std::max<size_t>(1, ((size_t)16 << 20) / corpusBytes);
+        auto timeTable = [&](const DFATable& t) {
+            auto t0 = std::chrono::steady_clock::now();
+            size_t matched = 0;
+            for (size_t r = 0; r < reps; ++r) {
+                for (const auto& line : corpus) matched += matchTable(t, line.data(), line.size());
+            }
+            auto t1 = std::chrono::steady_clock::now();
+            return std::make_pair(std::chrono::duration<double, std::milli>(t1 - t0).count(), matched);
+        };
+
+        DFAProfile prof = profileTable(table, corpus);
+        DFATable hot = relayoutTable(table, hotLayout(table, prof));
+        DFAProfile after = profileTable(hot, corpus);
+        auto before = timeTable(table);
+        auto relaid = timeTable(hot);
+        out << "# Profile: " << corpus.size() << " lines, mean cache-line distance per transition "
+            << lineDistance(prof) << " -> " << lineDistance(after) << " (self-loops excluded)\n";
+        // 耗时随机器而变，与 --bench 一样写到 std::cerr，输出文件只保留可复现的内容
+        std::cerr << "# Emit: " << regex << "\n";
+        std::cerr << "# Table match x" << reps << ": " << before.first << " ms -> " << relaid.first << " ms\n";
+        if (before.second != relaid.second) {
+            out << "Error: relaid-out table matches differently.\n";
+        }
+        table = hot;
+    }
+
+    std::string fileName = prefix + std::to_string(index) + ".dfa";
+    std::ofstream file(fileName, std::ios::binary);
+    if (!file || !writeTable(table, file)) {
+        std::cerr << "Error: Could not write table file: " << fileName << "\n";
+        return;
+    }
+    file.close();
+
+    // 读回校验
+    std::ifstream check(fileName, std::ios::binary);
+    DFATable loaded;
+    bool same = readTable(check, loaded) && loaded.start == table.start &&
+        loaded.classCount == table.classCount && loaded.byteClass == table.byteClass &&
+        loaded.next == table.next && loaded.accept == table.accept;
+    out << fileName << ": " << table.stateCount << " states" << (same ? "" : " (verify FAILED)") << "\n";
+}
+
+// -------------------- 流式（可恢复）匹配 --------------------
+// 数据从管道按任意大小分块到达。匹配器只保存当前 DFA 状态和上一个接受位置，
+// 逐块喂入，不缓存之前的块；跨块的记录照常识别，内存占用与流的长度无关。
+// 记录以分隔符（默认换行）隔开，空记录跳过。接口与无符号数识别（CODE）中的 PascalNumberStream 相同。
+
+// 一条记录的结果，偏移均为从流开头算起的绝对位置
+struct StreamMatch {
+    size_t begin;      // 记录起点
+    size_t end;        // 记录终点（不含）
+    bool matched;      // 整条记录是否匹配
+    size_t prefixEnd;  // 最长匹配前缀的终点，没有时为 std::string::npos
+};
+
+class StreamMatcher {
+public:
+    using Callback = std::function<void(const StreamMatch&)>;
+
+    StreamMatcher(const DFATable& t, Callback onRecord, const std::string& delimiters = "\n")
+        : table(t), onRecord(onRecord), isDelimiter(256, false) {
+        for (char c : delimiters) isDelimiter[static_cast<unsigned char>(c)] = true;
+        singleDelimiter = delimiters.size() == 1 ? delimiters[0] : '\0';
+        reset();
+    }
+
+    void feed(const char* data, size_t size) {
+        size_t i = 0;
+        while (i < size) {
+            // 已进入死状态：本条记录的结果已确定，直接找下一个分隔符。
+            // 单个分隔符用 memchr，多个分隔符（如 "\r\n"）查 isDelimiter 表
+            if (inRecord && state < 0) {
+                size_t skip;
+                if (singleDelimiter != '\0') {
+                    const void* hit = std::memchr(data + i, singleDelimiter, size - i);
+                    skip = hit ? (size_t)((const char*)hit - data) - i : size - i;
+                }
+                else {
+                    size_t j = i;
+                    while (j < size && !isDelimiter[static_cast<unsigned char>(data[j])]) ++j;
+                    skip = j - i;
+                }
+                i += skip;
+                offset += skip;
+                if (i == size) break;
+            }
+
+            unsigned char b = static_cast<unsigned char>(data[i]);
+            if (isDelimiter[b]) {
+                endRecord();
+            }
+            else {
+                if (!inRecord) {
+                    inRecord = true;
+                    recordBegin = offset;
+                    // 起始状态接受时，空前缀就是合法前缀
+                    if (state >= 0 && table.accept[state]) lastAccept = recordBegin;
+                }
+                if (state >= 0) {
+                    state = table.step(state, b);
+                    if (state >= 0 && table.accept[state]) lastAccept = offset + 1;
+                }
+            }
+            ++i;
+            ++offset;
+        }
+    }
+
+    // 流结束：报告最后一条没有分隔符结尾的记录
+    void finish() {
+        endRecord();
+    }
+
+private:
+    DFATable table;
+    Callback onRecord;
+    std::vector<bool> isDelimiter;
+    char singleDelimiter;
+    int state = -1;
+    size_t offset = 0;
+    size_t recordBegin = 0;
+    size_t lastAccept = std::string::npos;
+    bool inRecord = false;
+
+    void reset() {
+        state = table.start;
+        lastAccept = std::string::npos;
+        inRecord = false;
+    }
+
+    void endRecord() {
+        if (!inRecord) return;
+        bool matched = state >= 0 && table.accept[state];
+        onRecord({ recordBegin, offset, matched, lastAccept });
+        reset();
+    }
+};
+
+// 从文件（"-" 表示标准输入）分块读取，逐条记录输出整行匹配结果
+void printStream(const std::string& regex, const std::string& textFile, size_t chunkSize, std::ostream& out) {
+    DFATable table = compileTable(regex);
+
+    std::ifstream file;
+    std::istream* in = &std::cin;
+    if (textFile == "-") {
+#ifdef _WIN32
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    }
+    else {
+        file.open(textFile, std::ios::binary);
+        if (!file) {
+            std::cerr << "Error: Could not open text file: " << textFile << "\n";
+            return;
+        }
+        in = &file;
+    }
+
+    out << "--------------------------------------------------\n";
+    out << "# Stream: " << regex << "\n";
+    size_t records = 0, matched = 0;
+    StreamMatcher matcher(table, [&](const StreamMatch& m) {
+        ++records;
+        if (m.matched) ++matched;
+        out << m.begin << "-" << m.end << ": " << (m.matched ? "YES" : "NO");
+        if (!m.matched && m.prefixEnd != std::string::npos) {
+            out << " (longest match prefix ends at " << m.prefixEnd << ")";
+        }
+        out << "\n";
+    }, "\r\n");
+
+    std::vector<char> chunk(chunkSize);
+    while (in->read(chunk.data(), chunk.size()) || in->gcount() > 0) {
+        matcher.feed(chunk.data(), (size_t)in->gcount());
+    }
+    matcher.finish();
+    out << "# Records: " << records << ", matched: " << matched << "\n";
+}
+
+// 输入文件中每两行为一组，输出两条正规式布尔组合后的最简 DFA
+void printProduct(const std::string& regexA, const std::string& regexB, ProductOp op, std::ostream& out) {
+    NFAFactory factoryA, factoryB;
+    MinDFA a = minimizeDFA(nfaToDfa(factoryA.buildFromRegex(regexA)));
+    MinDFA b = minimizeDFA(nfaToDfa(factoryB.buildFromRegex(regexB)));
+
+    out << "--------------------------------------------------\n";
+    out << "# " << (op == ProductOp::Intersection ? "A & B" : "A - B") << "\n";
+    out << "# A: " << regexA << "\n";
+    out << "# B: " << regexB << "\n";
+    // 未最小化的状态数反映了剪枝的效果：不可能再接受的状态对不会生成
+    MinDFA product = productDFA(a, b, op);
+    MinDFA result = minimizeDFA(toDFA(product));
+    out << "# Product pairs explored: " << product.states.size() << ", minimal DFA states: " << result.states.size() << "\n";
+    printMinDFA(result, out);
+}
+
+void printComplement(const std::string& regex, std::ostream& out) {
+    NFAFactory factory;
+    MinDFA a = minimizeDFA(nfaToDfa(factory.buildFromRegex(regex)));
+
+    out << "--------------------------------------------------\n";
+    out << "# !A, A: " << regex << "\n";
+    printMinDFA(complementDFA(a), out);
+}
+
 // -------------------- 主函数 --------------------
 
 int main(int argc, char* argv[]) {
-    if (argc == 1) {
-        std::cerr << "Usage: " << argv[0] << " <input_file> [output_file]\n";
+    // 可选的模式参数：
+    // --equiv 每两行一组判定等价 / 包含
+    // --and / --minus 每两行一组求交 / 差，--not 对每行求补
+    // --search <text_file> 在文本文件中查找每行正规式的匹配
+    // --match <text_file> 用每行正规式整行匹配文本文件的各行，并输出捕获组
+    // --bench <text_file> 比较查表匹配与 JIT 匹配的耗时
+    // --stream <text_file|-> 分块读取文本，逐行整行匹配，内存占用与文本大小无关
+    // --emit <table_prefix> 把每行正规式的转移表写到 <table_prefix><行号>.dfa
+    // --threads N 使用 N 个线程做子集构造
+    // --profile <corpus_file> 与 --emit 同用，按语料中的热点重排状态编号
+    // --chunk N 与 --stream 同用，每次读取 N 字节（默认 64KiB），小块可用来检验跨块的记录
+    std::string mode;
+    unsigned threads = 1;
+    size_t chunkSize = 1 << 16;
+    std::string corpusFile;
+    int argi = 1;
+    while (argi < argc && std::string(argv[argi]).rfind("--", 0) == 0) {
+        std::string opt = argv[argi++];
+        if (opt == "--threads") {
+            int n = argi < argc ? std::atoi(argv[argi++]) : 0;
+            if (n <= 0) {
+                std::cerr << "Error: --threads expects a positive number.\n";
+                return 1;
+            }
+            threads = (unsigned)n;
+        }
+        else if (opt == "--chunk") {
+            int n = argi < argc ? std::atoi(argv[argi++]) : 0;
+            if (n <= 0) {
+                std::cerr << "Error: --chunk expects a positive number.\n";
+                return 1;
+            }
+            chunkSize = (size_t)n;
+        }
+        else if (opt == "--profile" && argi < argc) {
+            corpusFile = argv[argi++];
+        }
+        else {
+            mode = opt;
+        }
+    }
+    const std::set<std::string> modes = { "", "--equiv", "--and", "--minus", "--not", "--search", "--match", "--bench", "--emit", "--stream" };
+    if (!modes.count(mode)) {
+        std::cerr << "Error: Unknown option: " << mode << "\n";
+        return 1;
+    }
+
+    bool needsText = (mode == "--search" || mode == "--match" || mode == "--bench");
+    bool needsSecond = needsText || mode == "--emit" || mode == "--stream";
+    if (argi >= argc || (needsSecond && argi + 1 >= argc)) {
+        std::cerr << "Usage: " << argv[0] << " [--threads N] [--equiv|--and|--minus|--not] <input_file> [output_file]\n";
+        std::cerr << "       " << argv[0] << " --search|--match|--bench <input_file> <text_file> [output_file]\n";
+        std::cerr << "       " << argv[0] << " --emit [--profile corpus_file] <input_file> <table_prefix> [output_file]\n";
+        std::cerr << "       " << argv[0] << " --stream [--chunk N] <input_file> <text_file|-> [output_file]\n";
         return 1;
     }
 
-    std::string fileName = argv[1];
+    std::string fileName = argv[argi];
     std::ifstream inputFile(fileName);
     if (!inputFile) {
         std::cerr << "Error: Could not open input file: " << fileName << "\n";
         return 1;
     }
 
+    std::string text;
+    if (needsText) {
+        std::ifstream textFile(argv[++argi], std::ios::binary);
+        if (!textFile) {
+            std::cerr << "Error: Could not open text file: " << argv[argi] << "\n";
+            return 1;
+        }
+        text.assign(std::istreambuf_iterator<char>(textFile), std::istreambuf_iterator<char>());
+    }
+
+    std::string streamFile;
+    if (mode == "--stream") {
+        streamFile = argv[++argi];
+    }
+
+    std::string tablePrefix;
+    std::vector<std::string> corpus;
+    if (mode == "--emit") {
+        tablePrefix = argv[++argi];
+        if (!corpusFile.empty()) {
+            std::ifstream corpusInput(corpusFile, std::ios::binary);
+            if (!corpusInput) {
+                std::cerr << "Error: Could not open corpus file: " << corpusFile << "\n";
+                return 1;
+            }
+            std::string corpusText((std::istreambuf_iterator<char>(corpusInput)), std::istreambuf_iterator<char>());
+            for (const auto& l : splitLines(corpusText)) {
+                corpus.push_back(corpusText.substr(l.first, l.second));
+            }
+        }
+    }
+
     
     std::ostream* out = &std::cout;
     std::ofstream outputFile;
-    if (argc >= 3) {
-        outputFile.open(argv[2]);
+    if (argc >= argi + 2) {
+        outputFile.open(argv[argi + 1]);
         if (!outputFile) {
-            std::cerr << "Error: Could not open output file: " << argv[2] << "\n";
+            std::cerr << "Error: Could not open output file: " << argv[argi + 1] << "\n";
             return 1;
         }
         out = &outputFile;
@@ -758,6 +3142,61 @@ int main(int argc, char* argv[]) {
     
     std::string regex;
 
+    if (mode == "--equiv" || mode == "--and" || mode == "--minus") {
+        std::string other;
+        while (std::getline(inputFile, regex)) {
+            if (!std::getline(inputFile, other)) {
+                std::cerr << "Warning: unpaired regex at end of input: " << regex << "\n";
+                break;
+            }
+            if (mode == "--equiv") {
+                printEquivalence(regex, other, *out);
+            }
+            else {
+                printProduct(regex, other,
+                    mode == "--and" ? ProductOp::Intersection : ProductOp::Difference, *out);
+            }
+        }
+        std::cerr << "\nINFO: End of input file reached.\n";
+        return 0;
+    }
+
+    if (needsText) {
+        while (std::getline(inputFile, regex)) {
+            if (mode == "--search") printSearch(regex, text, *out);
+            else if (mode == "--match") printCaptures(regex, text, *out);
+            else printBenchmark(regex, text, *out);
+        }
+        std::cerr << "\nINFO: End of input file reached.\n";
+        return 0;
+    }
+
+    if (mode == "--stream") {
+        // 标准输入只能读一遍，只用第一条正规式
+        while (std::getline(inputFile, regex)) {
+            printStream(regex, streamFile, chunkSize, *out);
+            if (streamFile == "-") break;
+        }
+        std::cerr << "\nINFO: End of input file reached.\n";
+        return 0;
+    }
+
+    if (mode == "--emit") {
+        int index = 0;
+        while (std::getline(inputFile, regex)) {
+            printEmit(regex, ++index, tablePrefix, corpus, *out);
+        }
+        std::cerr << "\nINFO: End of input file reached.\n";
+        return 0;
+    }
+
+    if (mode == "--not") {
+        while (std::getline(inputFile, regex)) {
+            printComplement(regex, *out);
+        }
+        std::cerr << "\nINFO: End of input file reached.\n";
+        return 0;
+    }
 
     while (true) {
         if (!std::getline(inputFile, regex)) {
@@ -773,7 +3212,7 @@ int main(int argc, char* argv[]) {
         printNFA(nfa, *out);
 
         // 3. NFA -> DFA
-        DFA dfa = nfaToDfa(nfa);
+        DFA dfa = nfaToDfaParallel(nfa, threads);
 
         // 4. 最小化 DFA
         MinDFA mdfa = minimizeDFA(dfa);
@@ -0,0 +1,69 @@
+#!/bin/sh
+# 本地检查：用 g++ 按 C++14 编译两个 C++ 项目，并核对样例输出。
+# 这里没有 <windows.h>，用 -Dnear= -Dfar= 模拟 minwindef.h 中的宏，提前发现与之冲突的标识符；
+# 完整的 MSVC 编译见 .github/workflows/msbuild.yml。
+set -e
+cd "$(dirname "$0")"
+CXX=${CXX:-g++}
+BUILD=${BUILD:-_check_build}
+mkdir -p "$BUILD"
+BUILD=$(cd "$BUILD" && pwd)
+
+for src in ConvertToDFA/DFA/Application.cpp CODE/PascalNumber/Application.cpp; do
+    $CXX -std=c++14 -fsyntax-only -Wall -Wextra -Dnear= -Dfar= "$src"
+done
+$CXX -std=c++14 -O2 -Wall -Wextra -pthread -o "$BUILD/ConvertToDFA" ConvertToDFA/DFA/Application.cpp
+$CXX -std=c++14 -O2 -Wall -Wextra -o "$BUILD/CODE" CODE/PascalNumber/Application.cpp
+
+# 各样例：sample <期望输出> <参数...>，输出写到 $BUILD 下同名文件后与期望输出比较；
+# 标准错误先存到 <期望输出>.err，失败时再打印出来
+cd ConvertToDFA
+sample() {
+    expected=$1
+    shift
+    if ! "$BUILD/ConvertToDFA" "$@" "$BUILD/$expected" 2>"$BUILD/$expected.err"; then
+        cat "$BUILD/$expected.err" >&2
+        echo "check failed: ConvertToDFA $* failed" >&2
+        exit 1
+    fi
+    if ! diff "$expected" "$BUILD/$expected"; then
+        echo "check failed: ConvertToDFA $* does not match $expected" >&2
+        exit 1
+    fi
+}
+sample output.txt input.txt
+sample search_output.txt --search search_input.txt search_text.txt
+sample match_output.txt --match match_input.txt match_text.txt
+sample bench_output.txt --bench bench_input.txt bench_text.txt
+sample equiv_output.txt --equiv equiv_input.txt
+sample and_output.txt --and product_input.txt
+sample minus_output.txt --minus product_input.txt
+sample not_output.txt --not not_input.txt
+sample output.txt --threads 4 input.txt
+sample utf8_output.txt utf8_input.txt
+
+# --emit 的输出中含表文件名，在 $BUILD 中以相对前缀 emit_ 运行，再逐字节核对写出的 DFATBL2 表
+SRC=$(pwd)
+(cd "$BUILD" && ./ConvertToDFA --emit --profile "$SRC/emit_corpus.txt" "$SRC/emit_input.txt" emit_ emit_output.txt 2>emit_output.txt.err) || {
+    cat "$BUILD/emit_output.txt.err" >&2
+    echo "check failed: ConvertToDFA --emit failed" >&2
+    exit 1
+}
+for f in emit_output.txt emit_1.dfa emit_2.dfa; do
+    if ! cmp "$f" "$BUILD/$f"; then
+        echo "check failed: --emit does not match $f" >&2
+        exit 1
+    fi
+done
+sample stream_output.txt --stream --chunk 3 stream_input.txt stream_text.txt
+
+# CODE --stream 从标准输入读取；每块 3 字节，使单词跨越块边界
+if ! "$BUILD/CODE" --stream 3 < ../CODE/stream_input.txt > "$BUILD/code_stream_output.txt"; then
+    echo "check failed: CODE --stream failed" >&2
+    exit 1
+fi
+if ! diff ../CODE/stream_output.txt "$BUILD/code_stream_output.txt"; then
+    echo "check failed: CODE --stream does not match CODE/stream_output.txt" >&2
+    exit 1
+fi
+echo "check passed"